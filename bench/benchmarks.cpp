@@ -0,0 +1,456 @@
+// benchmarks.cpp - Benchmarks do Paulo Roberto AI
+//
+// Mede as etapas quentes do servidor (tokenização, sentimentos, entidades,
+// cache e geração de documentos) com o corpus determinístico de corpus.h.
+// Uso:
+//   paulo_roberto_ai_bench [--filter texto] [--min-time segundos]
+//                          [--json saida.json] [--label commit] [--engines N]
+//                          [--engine-threads N]
+// O JSON traz um resultado por caso, para comparar execuções entre commits.
+#include "nlp_processor.h"
+#include "documents.h"
+#include "arena.h"
+#include "corpus.h"
+#include <filesystem>
+#include <iomanip>
+#include <numeric>
+#include <regex>
+#include <stdlib.h>
+
+// Alocações no heap do processo todo, contadas pelo operator new abaixo
+static atomic<uint64_t> allocationCount{0};
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* pointer = malloc(size ? size : 1)) return pointer;
+    throw bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+// Versões com alinhamento, usadas por exemplo pelo pmr::new_delete_resource
+void* operator new(size_t size, align_val_t alignment) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    if (void* pointer = aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align)) return pointer;
+    throw bad_alloc();
+}
+
+void operator delete(void* pointer, align_val_t) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t, align_val_t) noexcept {
+    free(pointer);
+}
+
+// Impede que o compilador descarte um resultado que não é usado
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchmarkResult {
+    string name;
+    string parameter;
+    size_t iterations = 0;
+    size_t bytesPerOp = 0;
+    double meanNs = 0.0;
+    double medianNs = 0.0;
+    double p90Ns = 0.0;
+    double minNs = 0.0;
+    double allocationsPerOp = -1.0;  // negativo: não medido
+    size_t itemsPerOp = 0;           // > 0: itens por operação (linhas de um lote)
+    size_t threads = 1;
+    double wallSeconds = 0.0;        // > 0: medição concorrente, vazão pelo relógio
+    
+    // Em medições concorrentes, operações concluídas por segundo somando as
+    // threads; nas seriais, o inverso da média
+    double opsPerSecond() const {
+        if (wallSeconds > 0.0) return static_cast<double>(iterations) / wallSeconds;
+        return meanNs > 0.0 ? 1e9 / meanNs : 0.0;
+    }
+    
+    double itemsPerSecond() const {
+        return opsPerSecond() * static_cast<double>(itemsPerOp);
+    }
+    
+    double megabytesPerSecond() const {
+        return meanNs > 0.0 ? static_cast<double>(bytesPerOp) / (1024.0 * 1024.0) * (1e9 / meanNs) : 0.0;
+    }
+    
+    json toJson() const {
+        json j = {
+            {"name", name},
+            {"parameter", parameter},
+            {"iterations", iterations},
+            {"mean_ns", meanNs},
+            {"median_ns", medianNs},
+            {"p90_ns", p90Ns},
+            {"min_ns", minNs},
+            {"ops_per_second", opsPerSecond()}
+        };
+        if (bytesPerOp > 0) j["mb_per_second"] = megabytesPerSecond();
+        if (allocationsPerOp >= 0.0) j["allocations_per_op"] = allocationsPerOp;
+        if (itemsPerOp > 0) j["items_per_second"] = itemsPerSecond();
+        if (wallSeconds > 0.0) {
+            j["threads"] = threads;
+            j["wall_seconds"] = wallSeconds;
+        }
+        return j;
+    }
+};
+
+class BenchmarkRunner {
+private:
+    string filter;
+    double minSeconds;
+    vector<BenchmarkResult> results;
+
+public:
+    BenchmarkRunner(string filter, double minSeconds) : filter(move(filter)), minSeconds(minSeconds) {}
+    
+    bool selected(const string& name) const {
+        return filter.empty() || name.find(filter) != string::npos;
+    }
+    
+    // Uma chamada de aquecimento e depois iterações cronometradas uma a uma
+    // até somar `minSeconds` (com pelo menos 5 amostras). As alocações por
+    // iteração incluem as de outras threads no mesmo intervalo.
+    template<typename Function>
+    void run(const string& name, const string& parameter, size_t bytesPerOp, Function&& function) {
+        if (!selected(name)) return;
+        function();
+        
+        vector<double> samples;
+        samples.reserve(1 << 16);
+        uint64_t allocationsBefore = allocationCount.load(memory_order_relaxed);
+        double total = 0.0;
+        while ((samples.size() < 5 || total < minSeconds * 1e9) && samples.size() < 10000000) {
+            auto start = chrono::steady_clock::now();
+            function();
+            double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            samples.push_back(elapsed);
+            total += elapsed;
+        }
+        uint64_t allocations = allocationCount.load(memory_order_relaxed) - allocationsBefore;
+        double allocationsPerOp = static_cast<double>(allocations) / static_cast<double>(samples.size());
+        record(name, parameter, bytesPerOp, move(samples), allocationsPerOp);
+    }
+    
+    // Para medições feitas fora do laço padrão (ex.: motores de inferência)
+    void record(const string& name, const string& parameter, size_t bytesPerOp, vector<double> samples,
+                double allocationsPerOp = -1.0, size_t itemsPerOp = 0) {
+        BenchmarkResult result = summarize(name, parameter, move(samples));
+        result.bytesPerOp = bytesPerOp;
+        result.allocationsPerOp = allocationsPerOp;
+        result.itemsPerOp = itemsPerOp;
+        print(result);
+        results.push_back(move(result));
+    }
+    
+    // Medição com várias threads ao mesmo tempo durante `wallSeconds`; as
+    // amostras são as latências de todas as chamadas de todas as threads
+    void recordConcurrent(const string& name, const string& parameter, size_t threads, size_t itemsPerOp,
+                          vector<double> samples, double wallSeconds) {
+        BenchmarkResult result = summarize(name, parameter, move(samples));
+        result.itemsPerOp = itemsPerOp;
+        result.threads = threads;
+        result.wallSeconds = wallSeconds;
+        print(result);
+        results.push_back(move(result));
+    }
+
+private:
+    static BenchmarkResult summarize(const string& name, const string& parameter, vector<double> samples) {
+        sort(samples.begin(), samples.end());
+        BenchmarkResult result;
+        result.name = name;
+        result.parameter = parameter;
+        result.iterations = samples.size();
+        if (samples.empty()) return result;
+        result.meanNs = accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+        result.medianNs = samples[samples.size() / 2];
+        result.p90Ns = samples[min(samples.size() - 1, samples.size() * 9 / 10)];
+        result.minNs = samples.front();
+        return result;
+    }
+    
+    static void print(const BenchmarkResult& result) {
+        cout << theme.primary << left << setw(28) << result.name << COLOR_RESET << setw(14) << result.parameter << right
+             << fixed << setprecision(1) << setw(14) << result.medianNs << " ns mediana"
+             << setw(14) << result.p90Ns << " ns p90" << setw(14) << result.opsPerSecond() << " op/s";
+        if (result.bytesPerOp > 0) cout << setw(10) << result.megabytesPerSecond() << " MB/s";
+        if (result.allocationsPerOp >= 0.0) cout << setw(10) << result.allocationsPerOp << " aloc/op";
+        if (result.itemsPerOp > 0) cout << setw(12) << result.itemsPerSecond() << " itens/s";
+        cout << defaultfloat << endl;
+    }
+
+public:
+    json toJson(const string& label) const {
+        json list = json::array();
+        for (const auto& result : results) list.push_back(result.toJson());
+        return {
+            {"label", label},
+            {"timestamp", static_cast<int64_t>(chrono::duration_cast<chrono::seconds>(
+                chrono::system_clock::now().time_since_epoch()).count())},
+            {"min_time_seconds", minSeconds},
+            {"results", list}
+        };
+    }
+};
+
+static string sizeLabel(size_t bytes) {
+    if (bytes >= 1024 * 1024) return to_string(bytes / (1024 * 1024)) + "MiB";
+    if (bytes >= 1024) return to_string(bytes / 1024) + "KiB";
+    return to_string(bytes) + "B";
+}
+
+// Tokenizador antigo, mantido só como referência de desempenho
+static vector<string> regexTokenize(const string& input) {
+    vector<string> tokens;
+    regex word_regex(R"([\w'-]+)");
+    auto words_begin = sregex_iterator(input.begin(), input.end(), word_regex);
+    auto words_end = sregex_iterator();
+    for (auto i = words_begin; i != words_end; ++i) {
+        tokens.push_back(i->str());
+    }
+    return tokens;
+}
+
+static void benchmarkText(BenchmarkRunner& runner, NLPProcessor& nlp) {
+    PortugueseCorpus corpus;
+    for (size_t size : {size_t(256), size_t(4096), size_t(65536), size_t(1024 * 1024)}) {
+        const string text = corpus.text(size);
+        const string label = sizeLabel(size);
+        runner.run("tokenize", label, text.size(), [&] { doNotOptimize(nlp.tokenize(text)); });
+        runner.run("sentiment", label, text.size(), [&] { doNotOptimize(nlp.analyzeSentiment(text)); });
+        runner.run("entities", label, text.size(), [&] { doNotOptimize(nlp.extractNamedEntities(text)); });
+    }
+    
+    const string text = corpus.text(4096);
+    runner.run("tokenize_regex_baseline", sizeLabel(4096), text.size(), [&] { doNotOptimize(regexTokenize(text)); });
+    
+    // Análise de um pedido de conversa com os temporários no heap (entidades
+    // copiadas para strings, como antes) e na arena da requisição
+    for (size_t size : {size_t(1024), size_t(16384)}) {
+        const string sample = corpus.text(size);
+        runner.run("analysis_heap", sizeLabel(size), sample.size(), [&] {
+            doNotOptimize(nlp.analyzeSentiment(sample));
+            doNotOptimize(nlp.extractNamedEntities(sample));
+        });
+        runner.run("analysis_arena", sizeLabel(size), sample.size(), [&] {
+            RequestArena arena;
+            doNotOptimize(nlp.analyzeSentiment(sample, arena.memory()));
+            doNotOptimize(nlp.findEntities(sample, arena.memory()));
+        });
+    }
+}
+
+static void benchmarkCache(BenchmarkRunner& runner, NLPProcessor& nlp) {
+    PortugueseCorpus corpus(7);
+    const string repeated = corpus.text(1024);
+    nlp.processText(repeated);
+    runner.run("process_text_hit", sizeLabel(1024), repeated.size(), [&] { doNotOptimize(nlp.processText(repeated)); });
+    
+    // Um texto novo a cada iteração: sempre falha nos dois níveis do cache
+    const string base = corpus.text(1024);
+    size_t counter = 0;
+    runner.run("process_text_miss", sizeLabel(1024), base.size(), [&] {
+        doNotOptimize(nlp.processText(base + " #" + to_string(counter++)));
+    });
+}
+
+static void benchmarkDocuments(BenchmarkRunner& runner) {
+    FileGenerator generator;
+    PortugueseCorpus corpus(11);
+    size_t written = 0;
+    ByteSink countingSink = [&written](const char*, size_t length) {
+        written += length;
+        return true;
+    };
+    
+    for (size_t count : {size_t(10), size_t(100), size_t(1000)}) {
+        const auto slides = corpus.slides(count);
+        runner.run("generate_pptx", to_string(count) + " slides", 0, [&] {
+            written = 0;
+            generator.generatePPTX(slides, countingSink);
+            doNotOptimize(written);
+        });
+    }
+    for (size_t rows : {size_t(100), size_t(10000), size_t(100000)}) {
+        if (!runner.selected("generate_xlsx")) break;
+        const auto table = corpus.table(rows);
+        runner.run("generate_xlsx", to_string(rows) + " linhas", 0, [&] {
+            written = 0;
+            generator.generateXLSX(table, countingSink);
+            doNotOptimize(written);
+        });
+    }
+}
+
+// Roda os mesmos lotes nos dois motores (model.pt e model.onnx) para escolher
+// o motor mais rápido por modelo. Primeiro uma thread de cada vez (latência);
+// depois `threads` threads dividindo o mesmo motor por `seconds`, como os
+// workers do InferenceScheduler fazem com uma única sessão, para medir lotes
+// e itens por segundo sob concorrência.
+static void benchmarkEngines(BenchmarkRunner& runner, size_t iterations, size_t threads, double seconds) {
+    const vector<string> sentences = {
+        "O atendimento foi ótimo e a entrega chegou antes do prazo.",
+        "Produto péssimo, veio quebrado e ninguém respondeu meus e-mails.",
+        "Gostaria de saber o horário de funcionamento da loja em São Paulo.",
+        "A reunião com João Silva ficou para amanhã às dez horas.",
+        "Não gostei da cor, mas a qualidade do tecido é excelente.",
+        "Preciso de uma segunda via do boleto referente ao mês passado.",
+        "O aplicativo trava toda vez que tento finalizar a compra.",
+        "Vocês entregam no interior de Minas Gerais?"
+    };
+    
+    InferenceTunables tunables;
+    vector<shared_ptr<InferenceEngine>> engines;
+    for (const string& preference : {string("torch"), string("onnx")}) {
+        try {
+            engines.push_back(loadInferenceEngine(preference, tunables.intraOpThreads));
+        } catch (const exception& e) {
+            cerr << theme.error << "Motor " << preference << " indisponível: " << e.what() << COLOR_RESET << endl;
+        }
+    }
+    
+    for (size_t batchSize : {size_t(1), tunables.maxBatch}) {
+        vector<vector<int64_t>> sequences;
+        size_t longest = 0;
+        for (size_t i = 0; i < batchSize; ++i) {
+            sequences.push_back(InferenceBatch::encode(sentences[i % sentences.size()], tunables.maxSequence,
+                                                       tunables.vocabularySize));
+            longest = max(longest, sequences.back().size());
+        }
+        InferenceBatch batch;
+        batch.reset(batchSize, longest);
+        for (size_t row = 0; row < batchSize; ++row) batch.setRow(row, sequences[row]);
+        
+        for (const auto& engine : engines) {
+            engine->prepareThread();
+            for (int i = 0; i < 3; ++i) engine->run(batch);  // aquecimento
+            
+            vector<double> samples;
+            samples.reserve(iterations);
+            for (size_t i = 0; i < iterations; ++i) {
+                auto start = chrono::steady_clock::now();
+                engine->run(batch);
+                samples.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+            }
+            runner.record(string("inference_") + engine->name(), "lote " + to_string(batchSize), 0, move(samples),
+                          -1.0, batchSize);
+        }
+        
+        for (const auto& engine : engines) {
+            if (threads < 2) break;
+            vector<vector<double>> perThread(threads);
+            vector<thread> workers;
+            atomic<bool> failed{false};
+            atomic<size_t> ready{0};
+            atomic<bool> go{false};
+            chrono::steady_clock::time_point started, deadline;
+            for (size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    try {
+                        engine->prepareThread();
+                        engine->run(batch);  // aquecimento da thread
+                        ready.fetch_add(1);
+                        while (!go.load(memory_order_acquire)) this_thread::yield();
+                        auto now = chrono::steady_clock::now();
+                        while (now < deadline) {
+                            engine->run(batch);
+                            auto finished = chrono::steady_clock::now();
+                            perThread[t].push_back(chrono::duration<double, nano>(finished - now).count());
+                            now = finished;
+                        }
+                    } catch (const exception& e) {
+                        failed = true;
+                        cerr << theme.error << "Erro no motor " << engine->name() << ": " << e.what() << COLOR_RESET << endl;
+                    }
+                });
+            }
+            // O relógio só começa quando todas as threads aqueceram
+            while (ready.load() < threads && !failed) this_thread::yield();
+            started = chrono::steady_clock::now();
+            deadline = started + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+            go.store(true, memory_order_release);
+            for (auto& worker : workers) worker.join();
+            double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+            if (failed) continue;
+            
+            vector<double> samples;
+            for (auto& own : perThread) samples.insert(samples.end(), own.begin(), own.end());
+            runner.recordConcurrent(string("inference_") + engine->name() + "_concurrent",
+                                    "lote " + to_string(batchSize) + " x" + to_string(threads), threads, batchSize,
+                                    move(samples), wallSeconds);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    string filter;
+    string jsonPath;
+    string label = getenv("GIT_COMMIT") ? getenv("GIT_COMMIT") : "";
+    double minSeconds = 0.5;
+    size_t engineIterations = 0;
+    size_t engineThreads = max(2u, thread::hardware_concurrency());
+    
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+        else if (arg == "--label" && hasValue) label = argv[++i];
+        else if (arg == "--min-time" && hasValue) minSeconds = atof(argv[++i]);
+        else if (arg == "--engines") engineIterations = hasValue && isdigit(argv[i + 1][0]) ? stoul(argv[++i]) : 200;
+        else if (arg == "--engine-threads" && hasValue) engineThreads = static_cast<size_t>(atoi(argv[++i]));
+        else {
+            cerr << theme.error << "Argumento desconhecido: " << arg << COLOR_RESET << endl;
+            cerr << "Uso: " << argv[0] << " [--filter texto] [--min-time segundos] [--json saida.json]"
+                 << " [--label commit] [--engines N] [--engine-threads N]" << endl;
+            return 1;
+        }
+    }
+    
+    if (!jsonPath.empty()) jsonPath = filesystem::absolute(jsonPath).string();
+    
+    // O NLP abre nlp_cache.db no diretório atual; um diretório temporário
+    // garante que o cache persistente comece vazio em toda execução
+    char workspace[] = "/tmp/paulo_roberto_bench_XXXXXX";
+    if (!mkdtemp(workspace) || chdir(workspace) != 0) {
+        cerr << theme.error << "Não foi possível criar o diretório temporário" << COLOR_RESET << endl;
+        return 1;
+    }
+    
+    BenchmarkRunner runner(filter, minSeconds);
+    {
+        NLPProcessor nlp;
+        while (!nlp.isReady()) this_thread::sleep_for(chrono::milliseconds(5));
+        benchmarkText(runner, nlp);
+        benchmarkCache(runner, nlp);
+    }
+    benchmarkDocuments(runner);
+    if (engineIterations > 0) benchmarkEngines(runner, engineIterations, engineThreads, max(minSeconds, 1.0));
+    
+    if (!jsonPath.empty()) {
+        ofstream out(jsonPath);
+        out << runner.toJson(label).dump(2) << endl;
+        if (!out) {
+            cerr << theme.error << "Erro ao gravar " << jsonPath << COLOR_RESET << endl;
+            return 1;
+        }
+        cout << theme.success << "Resultados gravados em " << jsonPath << COLOR_RESET << endl;
+    }
+    
+    error_code ignored;
+    filesystem::remove_all(workspace, ignored);
+    return 0;
+}
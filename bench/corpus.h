@@ -0,0 +1,147 @@
+// corpus.h - Gerador determinístico de textos em português para os benchmarks
+#pragma once
+
+#include "common.h"
+
+// Frases com vocabulário do léxico de sentimentos, nomes, cidades e, de vez
+// em quando, e-mails, telefones e CPFs válidos. A mesma semente gera sempre
+// o mesmo texto, para que execuções em commits diferentes sejam comparáveis.
+class PortugueseCorpus {
+private:
+    mt19937_64 random;
+    
+    static constexpr array<const char*, 16> FIRST_NAMES = {
+        "João", "Maria", "José", "Ana", "Paulo", "Fernanda", "Carlos", "Juliana",
+        "Antônio", "Beatriz", "Luís", "Camila", "Rafael", "Letícia", "Marcelo", "Patrícia"
+    };
+    static constexpr array<const char*, 12> LAST_NAMES = {
+        "Silva", "Santos", "Oliveira", "Souza", "Pereira", "Costa",
+        "Rodrigues", "Almeida", "Nascimento", "Lima", "Araújo", "Gonçalves"
+    };
+    static constexpr array<const char*, 10> CITIES = {
+        "São Paulo", "Rio de Janeiro", "Belo Horizonte", "Curitiba", "Porto Alegre",
+        "Salvador", "Recife", "Fortaleza", "Brasília", "Florianópolis"
+    };
+    static constexpr array<const char*, 10> SUBJECTS = {
+        "o atendimento", "a entrega", "o produto", "o aplicativo", "a loja",
+        "o suporte", "a reunião", "o relatório", "a apresentação", "o preço"
+    };
+    static constexpr array<const char*, 6> VERBS = {
+        "foi", "ficou", "parece", "está", "continua", "era"
+    };
+    static constexpr array<const char*, 12> ADJECTIVES = {
+        "ótimo", "excelente", "bom", "maravilhoso", "rápido", "eficiente",
+        "péssimo", "ruim", "horrível", "lento", "confuso", "razoável"
+    };
+    static constexpr array<const char*, 4> INTENSIFIERS = {"muito", "extremamente", "bastante", "pouco"};
+    static constexpr array<const char*, 8> FILLERS = {
+        "segundo o cliente", "na semana passada", "como sempre", "mais uma vez",
+        "de acordo com a equipe", "depois da atualização", "no fim do mês", "durante a visita"
+    };
+    
+    template<size_t N>
+    const char* pick(const array<const char*, N>& words) {
+        return words[random() % N];
+    }
+    
+    size_t chance(size_t outOf) {
+        return random() % outOf;
+    }
+    
+    string person() {
+        return string(pick(FIRST_NAMES)) + " " + pick(LAST_NAMES);
+    }
+    
+    string email() {
+        string name = pick(FIRST_NAMES);
+        string address;
+        for (unsigned char c : name) {
+            if (c < 0x80) address += static_cast<char>(tolower(c));
+        }
+        return address + "." + to_string(random() % 1000) + "@exemplo.com.br";
+    }
+    
+    string phone() {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "(%02u) 9%04u-%04u", static_cast<unsigned>(11 + random() % 88),
+                 static_cast<unsigned>(random() % 10000), static_cast<unsigned>(random() % 10000));
+        return buffer;
+    }
+    
+    // CPF com dígitos verificadores corretos, formatado com pontos e hífen
+    string cpf() {
+        int digits[11];
+        for (int i = 0; i < 9; ++i) digits[i] = static_cast<int>(random() % 10);
+        for (int check = 9; check < 11; ++check) {
+            int sum = 0;
+            for (int i = 0; i < check; ++i) sum += digits[i] * (check + 1 - i);
+            int rest = (sum * 10) % 11;
+            digits[check] = rest == 10 ? 0 : rest;
+        }
+        string out;
+        for (int i = 0; i < 11; ++i) {
+            if (i == 3 || i == 6) out += '.';
+            if (i == 9) out += '-';
+            out += static_cast<char>('0' + digits[i]);
+        }
+        return out;
+    }
+    
+public:
+    explicit PortugueseCorpus(uint64_t seed = 42) : random(seed) {}
+    
+    string sentence() {
+        string s = pick(SUBJECTS);
+        s[0] = static_cast<char>(toupper(static_cast<unsigned char>(s[0])));
+        if (chance(3) == 0) s += string(" em ") + pick(CITIES);
+        s += " ";
+        if (chance(5) == 0) s += "não ";
+        s += pick(VERBS);
+        s += " ";
+        if (chance(3) == 0) s += string(pick(INTENSIFIERS)) + " ";
+        s += pick(ADJECTIVES);
+        if (chance(2) == 0) s += string(", ") + pick(FILLERS);
+        
+        switch (chance(10)) {
+            case 0: s += ", disse " + person(); break;
+            case 1: s += ", escreveu " + person() + " (" + email() + ")"; break;
+            case 2: s += ", contato pelo telefone " + phone(); break;
+            case 3: s += ", cliente com CPF " + cpf(); break;
+            default: break;
+        }
+        s += chance(8) == 0 ? "!" : ".";
+        return s;
+    }
+    
+    // Frases até completar pelo menos `bytes` bytes
+    string text(size_t bytes) {
+        string out;
+        out.reserve(bytes + 256);
+        while (out.size() < bytes) {
+            if (!out.empty()) out += ' ';
+            out += sentence();
+        }
+        return out;
+    }
+    
+    vector<string> slides(size_t count) {
+        vector<string> out;
+        out.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back(sentence() + " " + sentence());
+        }
+        return out;
+    }
+    
+    // Planilha com cabeçalho e `rows` linhas de texto e números
+    vector<vector<string>> table(size_t rows) {
+        vector<vector<string>> out;
+        out.reserve(rows + 1);
+        out.push_back({"Cliente", "Cidade", "Assunto", "Avaliação", "Quantidade", "Valor"});
+        for (size_t i = 0; i < rows; ++i) {
+            out.push_back({person(), pick(CITIES), pick(SUBJECTS), pick(ADJECTIVES),
+                           to_string(1 + random() % 500), to_string(random() % 100000) + "." + to_string(random() % 100)});
+        }
+        return out;
+    }
+};
@@ -2,7 +2,7 @@
 
 # Instalar dependências
 apt-get update
-apt-get install -y build-essential libzip-dev libssl-dev libxml2-dev libicu-dev
+apt-get install -y build-essential zlib1g-dev libssl-dev libxml2-dev libicu-dev libsqlite3-dev
 
 # Baixar e extrair ONNX Runtime
 wget https://github.com/microsoft/onnxruntime/releases/download/v1.10.0/onnxruntime-linux-x64-1.10.0.tgz
@@ -14,12 +14,23 @@ wget https://download.pytorch.org/libtorch/cpu/libtorch-cxx11-abi-shared-with-de
 unzip libtorch-cxx11-abi-shared-with-deps-1.10.1+cpu.zip
 export Torch_DIR=$(pwd)/libtorch
 
-# Compilar o projeto
-g++ -std=c++17 -o paulo_roberto_ai main.cpp \
-    -I${ONNXRUNTIME_DIR}/include -L${ONNXRUNTIME_DIR}/lib -lonnxruntime \
-    -I${Torch_DIR}/include -I${Torch_DIR}/include/torch/csrc/api/include \
+# Compilar o projeto: o código de src/ vira uma biblioteca estática usada
+# pelo servidor e pelo binário de benchmarks
+INCLUDES="-Isrc -I/usr/include/libxml2 \
+    -I${ONNXRUNTIME_DIR}/include \
+    -I${Torch_DIR}/include -I${Torch_DIR}/include/torch/csrc/api/include"
+LIBS="-L${ONNXRUNTIME_DIR}/lib -lonnxruntime \
     -L${Torch_DIR}/lib -ltorch -ltorch_cpu -lc10 \
-    -lzip -lssl -lcrypto -lxml2 -licuuc -licudata -lhttplib -lpthread
+    -lz -lssl -lcrypto -lxml2 -lsqlite3 -licuuc -licudata -lhttplib -lpthread"
+
+mkdir -p build
+for source in src/*.cpp; do
+    g++ -std=c++17 -O2 ${INCLUDES} -c "$source" -o "build/$(basename "${source%.cpp}").o" || exit 1
+done
+ar rcs build/libpaulo_roberto_ai.a build/*.o
+
+g++ -std=c++17 -O2 ${INCLUDES} -o paulo_roberto_ai main.cpp build/libpaulo_roberto_ai.a ${LIBS} || exit 1
+g++ -std=c++17 -O2 ${INCLUDES} -Ibench -o paulo_roberto_ai_bench bench/benchmarks.cpp build/libpaulo_roberto_ai.a ${LIBS} || exit 1
 
 # Criar diretório público
 mkdir -p public
@@ -0,0 +1,59 @@
+// arena.h - Arena de memória por requisição
+#pragma once
+
+#include "common.h"
+
+// Memória de curta duração de uma requisição (tokens, entidades, seções da
+// resposta). As alocações só avançam um ponteiro num buffer da própria
+// thread, reaproveitado de uma requisição para a outra, e são liberadas todas
+// juntas no destrutor, sem passar pelo malloc nem disputar os locks dele
+// entre as threads do httplib. Se o buffer acabar, os blocos seguintes vêm
+// do heap e também são liberados no destrutor.
+//
+// Não é thread-safe: o que for alocado aqui não deve ir para outras threads
+// nem sobreviver à arena. Uma arena criada enquanto outra está ativa na mesma
+// thread não usa o buffer da thread.
+class RequestArena {
+private:
+    static constexpr size_t THREAD_BUFFER_BYTES = 64 * 1024;
+    
+    struct ThreadBuffer {
+        alignas(max_align_t) array<byte, THREAD_BUFFER_BYTES> bytes;
+        bool inUse = false;
+    };
+    
+    static ThreadBuffer& threadBuffer() {
+        static thread_local unique_ptr<ThreadBuffer> buffer = make_unique<ThreadBuffer>();
+        return *buffer;
+    }
+    
+    ThreadBuffer* buffer;
+    pmr::monotonic_buffer_resource resource;
+    
+    static ThreadBuffer* acquire() {
+        ThreadBuffer& own = threadBuffer();
+        if (own.inUse) return nullptr;
+        own.inUse = true;
+        return &own;
+    }
+    
+    static pmr::monotonic_buffer_resource makeResource(ThreadBuffer* buffer) {
+        if (!buffer) return pmr::monotonic_buffer_resource(THREAD_BUFFER_BYTES, pmr::new_delete_resource());
+        return pmr::monotonic_buffer_resource(buffer->bytes.data(), buffer->bytes.size(), pmr::new_delete_resource());
+    }
+    
+public:
+    RequestArena() : buffer(acquire()), resource(makeResource(buffer)) {}
+    
+    ~RequestArena() {
+        resource.release();
+        if (buffer) buffer->inUse = false;
+    }
+    
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+    
+    pmr::memory_resource* memory() {
+        return &resource;
+    }
+};
@@ -0,0 +1,304 @@
+// artifact_cache.h - Cache de documentos gerados
+#pragma once
+
+#include "common.h"
+#include "telemetry.h"
+#include <openssl/evp.h>  // Criptografia
+#include <filesystem>
+
+// Versão dos bytes produzidos pelo FileGenerator. Entra na chave (e portanto
+// no ETag forte) e no nome do diretório de spill: aumente sempre que o
+// gerador passar a produzir outros bytes para as mesmas entradas, senão
+// clientes recebem 304 e o spill devolve arquivos do formato antigo.
+inline constexpr unsigned ARTIFACT_FORMAT_VERSION = 2;
+
+// Limites do cache de documentos; `spillDir` vazio desliga o spill em disco
+struct ArtifactCacheBudget {
+    size_t maxBytes = 64 * 1024 * 1024;
+    string spillDir;
+    size_t maxSpillBytes = 256 * 1024 * 1024;
+};
+
+// Cache de documentos gerados, endereçado por um hash das entradas. Mantém
+// até `maxBytes` em memória (LRU) e, se houver diretório de spill, guarda lá
+// os itens despejados (até `maxSpillBytes`) em vez de descartá-los. Os
+// arquivos de uma execução anterior são readotados na construção.
+class ArtifactCache {
+private:
+    using LruList = list<pair<string, shared_ptr<const string>>>;
+    
+    const size_t maxBytes;
+    const string spillRoot;
+    const string spillDir;  // spillRoot/v<ARTIFACT_FORMAT_VERSION>
+    const size_t maxSpillBytes;
+    
+    mutex mtx;
+    LruList lru;  // mais recente na frente
+    unordered_map<string, LruList::iterator> index;
+    size_t bytes = 0;
+    deque<pair<string, size_t>> spilled;  // mais antigo na frente
+    size_t spilledBytes = 0;
+    
+    static constexpr const char* SPILL_SUFFIX = ".bin";
+    static constexpr const char* PARTIAL_SUFFIX = ".tmp";
+    
+    string spillPath(const string& key) const {
+        return spillDir + "/" + key + SPILL_SUFFIX;
+    }
+    
+    static bool isKey(string_view name) {
+        return name.size() == 64 && name.find_first_not_of("0123456789abcdef") == string_view::npos;
+    }
+    
+    static string versionDir(const string& root) {
+        return root.empty() ? root : root + "/v" + to_string(ARTIFACT_FORMAT_VERSION);
+    }
+    
+    // Apaga o spill de outras versões do formato: os subdiretórios v<n> e os
+    // arquivos soltos na raiz, de antes de haver versão
+    void purgeOtherVersions() {
+        error_code ec;
+        string current = "v" + to_string(ARTIFACT_FORMAT_VERSION);
+        for (const auto& entry : filesystem::directory_iterator(spillRoot, ec)) {
+            string name = entry.path().filename().string();
+            if (entry.is_directory(ec)) {
+                bool versioned = name.size() > 1 && name[0] == 'v' &&
+                                 name.find_first_not_of("0123456789", 1) == string::npos;
+                if (versioned && name != current) filesystem::remove_all(entry.path(), ec);
+            } else if (isKey(entry.path().stem().string())) {
+                string extension = entry.path().extension().string();
+                if (extension == SPILL_SUFFIX || extension == PARTIAL_SUFFIX) filesystem::remove(entry.path(), ec);
+            }
+        }
+    }
+    
+    // Readota os itens gravados por uma execução anterior com a mesma versão
+    // do formato, do mais antigo para o mais novo, e apaga o que passar do
+    // limite, tiver ficado pela metade ou for de outra versão. Outros
+    // arquivos do diretório não são tocados.
+    void adoptSpilled() {
+        error_code ec;
+        purgeOtherVersions();
+        filesystem::create_directories(spillDir, ec);
+        if (ec) {
+            cerr << theme.error << "Não foi possível criar o diretório de spill " << spillDir << ": "
+                 << ec.message() << COLOR_RESET << endl;
+            return;
+        }
+        
+        vector<tuple<filesystem::file_time_type, string, size_t>> found;
+        for (const auto& entry : filesystem::directory_iterator(spillDir, ec)) {
+            if (!entry.is_regular_file(ec)) continue;
+            string stem = entry.path().stem().string();
+            string extension = entry.path().extension().string();
+            if (!isKey(stem)) continue;
+            
+            if (extension == PARTIAL_SUFFIX) {
+                filesystem::remove(entry.path(), ec);
+            } else if (extension == SPILL_SUFFIX) {
+                found.emplace_back(entry.last_write_time(ec), stem, entry.file_size(ec));
+            }
+        }
+        sort(found.begin(), found.end());
+        
+        for (auto& [modified, key, size] : found) {
+            spilled.emplace_back(move(key), size);
+            spilledBytes += size;
+        }
+        while (spilledBytes > maxSpillBytes && !spilled.empty()) {
+            spilledBytes -= spilled.front().second;
+            filesystem::remove(spillPath(spilled.front().first), ec);
+            spilled.pop_front();
+        }
+    }
+    
+    // Chamado com `mtx` travado; devolve os itens despejados da memória
+    LruList evictOverflow() {
+        LruList evicted;
+        while (bytes > maxBytes && !lru.empty()) {
+            auto last = prev(lru.end());
+            bytes -= last->second->size();
+            index.erase(last->first);
+            evicted.splice(evicted.end(), lru, last);
+        }
+        return evicted;
+    }
+    
+    // Grava no disco os itens despejados, fora do lock
+    void spill(LruList& evicted) {
+        if (spillDir.empty()) return;
+        
+        for (const auto& [key, content] : evicted) {
+            if (content->size() > maxSpillBytes) continue;
+            
+            // Grava ao lado e renomeia, para que um arquivo pela metade nunca
+            // seja readotado como documento completo
+            string path = spillPath(key);
+            string partial = spillDir + "/" + key + PARTIAL_SUFFIX;
+            {
+                ofstream file(partial, ios::binary | ios::trunc);
+                file.write(content->data(), static_cast<streamsize>(content->size()));
+                if (!file.flush()) {
+                    file.close();
+                    remove(partial.c_str());
+                    continue;
+                }
+            }
+            if (rename(partial.c_str(), path.c_str()) != 0) {
+                remove(partial.c_str());
+                continue;
+            }
+            
+            vector<string> dropped;
+            {
+                lock_guard<mutex> lock(mtx);
+                spilled.emplace_back(key, content->size());
+                spilledBytes += content->size();
+                while (spilledBytes > maxSpillBytes && !spilled.empty()) {
+                    spilledBytes -= spilled.front().second;
+                    dropped.push_back(move(spilled.front().first));
+                    spilled.pop_front();
+                }
+            }
+            for (const auto& old : dropped) remove(spillPath(old).c_str());
+        }
+    }
+    
+    shared_ptr<const string> loadSpilled(const string& key) {
+        {
+            lock_guard<mutex> lock(mtx);
+            auto it = find_if(spilled.begin(), spilled.end(), [&](const auto& item) { return item.first == key; });
+            if (it == spilled.end()) return nullptr;
+            spilledBytes -= it->second;
+            spilled.erase(it);
+        }
+        
+        string path = spillPath(key);
+        ifstream file(path, ios::binary);
+        if (!file) return nullptr;
+        auto content = make_shared<string>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        file.close();
+        remove(path.c_str());
+        return content;
+    }
+    
+public:
+    explicit ArtifactCache(const ArtifactCacheBudget& budget = {})
+        : maxBytes(budget.maxBytes), spillRoot(budget.spillDir), spillDir(versionDir(spillRoot)),
+          maxSpillBytes(budget.maxSpillBytes) {
+        if (!spillDir.empty()) adoptSpilled();
+    }
+    
+    // Chave (SHA-256 em hex) para a versão do formato, um tipo de documento e
+    // suas entradas. Cada campo vai prefixado pelo tamanho para que entradas
+    // diferentes não serializem igual.
+    class KeyBuilder {
+    private:
+        unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+        
+    public:
+        explicit KeyBuilder(string_view kind) {
+            if (!ctx || EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr) != 1) {
+                throw runtime_error("Erro ao inicializar SHA-256");
+            }
+            add(to_string(ARTIFACT_FORMAT_VERSION));
+            add(kind);
+        }
+        
+        KeyBuilder& add(string_view field) {
+            uint64_t size = field.size();
+            EVP_DigestUpdate(ctx.get(), &size, sizeof(size));
+            EVP_DigestUpdate(ctx.get(), field.data(), field.size());
+            return *this;
+        }
+        
+        string hex() {
+            unsigned char digest[EVP_MAX_MD_SIZE];
+            unsigned int length = 0;
+            EVP_DigestFinal_ex(ctx.get(), digest, &length);
+            
+            static const char* hex_chars = "0123456789abcdef";
+            string out;
+            out.reserve(length * 2);
+            for (unsigned int i = 0; i < length; ++i) {
+                out += hex_chars[digest[i] >> 4];
+                out += hex_chars[digest[i] & 0xf];
+            }
+            return out;
+        }
+    };
+    
+    static string keyFor(const vector<string>& slides) {
+        KeyBuilder key("pptx");
+        for (const auto& slide : slides) key.add(slide);
+        return key.hex();
+    }
+    
+    static string keyFor(const vector<vector<string>>& data) {
+        KeyBuilder key("xlsx");
+        for (const auto& row : data) {
+            key.add(to_string(row.size()));
+            for (const auto& cell : row) key.add(cell);
+        }
+        return key.hex();
+    }
+    
+    // ETag forte: o gerador é determinístico, então a chave identifica os bytes
+    static string etagFor(const string& key) {
+        return "\"" + key + "\"";
+    }
+    
+    // Tamanho máximo de um item; maiores não são guardados
+    size_t maxEntryBytes() const {
+        return maxBytes / 8;
+    }
+    
+    shared_ptr<const string> get(const string& key) {
+        static auto& memoryHits = Telemetry::get().counter(
+            "paulo_artifact_cache_requests_total", "Consultas ao cache de documentos gerados", "result=\"memory_hit\"");
+        static auto& diskHits = Telemetry::get().counter(
+            "paulo_artifact_cache_requests_total", "Consultas ao cache de documentos gerados", "result=\"disk_hit\"");
+        static auto& misses = Telemetry::get().counter(
+            "paulo_artifact_cache_requests_total", "Consultas ao cache de documentos gerados", "result=\"miss\"");
+        
+        {
+            lock_guard<mutex> lock(mtx);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                lru.splice(lru.begin(), lru, it->second);
+                memoryHits.add();
+                return it->second->second;
+            }
+        }
+        
+        shared_ptr<const string> content;
+        if (!spillDir.empty()) content = loadSpilled(key);
+        if (content) {
+            put(key, content);
+            diskHits.add();
+        } else {
+            misses.add();
+        }
+        return content;
+    }
+    
+    void put(const string& key, shared_ptr<const string> content) {
+        if (!content || content->size() > maxEntryBytes()) return;
+        
+        LruList evicted;
+        {
+            lock_guard<mutex> lock(mtx);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                lru.splice(lru.begin(), lru, it->second);
+                return;
+            }
+            
+            bytes += content->size();
+            lru.emplace_front(key, move(content));
+            index.emplace(key, lru.begin());
+            evicted = evictOverflow();
+        }
+        spill(evicted);
+    }
+};
@@ -0,0 +1,527 @@
+// cache.h - Caches do processamento de texto (memória e SQLite)
+#pragma once
+
+#include "common.h"
+#include <zlib.h>
+#include <sqlite3.h>  // Banco de dados para histórico
+#include <openssl/evp.h>  // Criptografia
+
+// Agrupa chamadas concorrentes com a mesma chave: a primeira executa a
+// função e as demais esperam pelo mesmo resultado (ou exceção), em vez de
+// repetirem o trabalho
+template <typename T>
+class SingleFlight {
+private:
+    mutex mtx;
+    unordered_map<string, shared_future<T>> inFlight;
+    atomic<uint64_t> coalesced{0};
+    
+public:
+    template <typename F>
+    T run(const string& key, F&& fn) {
+        promise<T> leader;
+        shared_future<T> result;
+        {
+            lock_guard<mutex> lock(mtx);
+            auto it = inFlight.find(key);
+            if (it != inFlight.end()) {
+                coalesced.fetch_add(1, memory_order_relaxed);
+                result = it->second;
+            } else {
+                inFlight.emplace(key, leader.get_future().share());
+            }
+        }
+        if (result.valid()) return result.get();
+        
+        try {
+            T value = fn();
+            leader.set_value(value);
+            lock_guard<mutex> lock(mtx);
+            inFlight.erase(key);
+            return value;
+        } catch (...) {
+            leader.set_exception(current_exception());
+            lock_guard<mutex> lock(mtx);
+            inFlight.erase(key);
+            throw;
+        }
+    }
+    
+    // Quantas chamadas aproveitaram o resultado de outra em andamento
+    uint64_t coalescedCount() const {
+        return coalesced.load(memory_order_relaxed);
+    }
+};
+
+// LRU em memória dividido em shards, cada um com seu próprio mutex, para que
+// requisições concorrentes raramente disputem o mesmo lock. Limitado tanto
+// pelo número de itens quanto pelos bytes de chave + valor; um item maior que
+// a fatia de bytes de um shard não é guardado.
+class ShardedLruCache {
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+    
+    struct Shard {
+        mutex mtx;
+        list<pair<string, string>> items;  // mais recente na frente
+        unordered_map<string_view, list<pair<string, string>>::iterator> index;
+        size_t bytes = 0;
+    };
+    
+    array<Shard, SHARD_COUNT> shards;
+    const size_t shardCapacity;
+    const size_t shardMaxBytes;
+    
+    Shard& shardFor(string_view key) {
+        return shards[hash<string_view>{}(key) % SHARD_COUNT];
+    }
+    
+    static size_t charge(const string& key, const string& value) {
+        return key.size() + value.size();
+    }
+    
+    // Chamado com o mutex do shard travado
+    void evictOverflow(Shard& shard) {
+        while (!shard.items.empty() && (shard.items.size() > shardCapacity || shard.bytes > shardMaxBytes)) {
+            auto& last = shard.items.back();
+            shard.bytes -= charge(last.first, last.second);
+            shard.index.erase(last.first);
+            shard.items.pop_back();
+        }
+    }
+    
+public:
+    ShardedLruCache(size_t capacity, size_t maxBytes)
+        : shardCapacity(max<size_t>(capacity / SHARD_COUNT, 1)),
+          shardMaxBytes(max<size_t>(maxBytes / SHARD_COUNT, 1)) {}
+    
+    optional<string> get(const string& key) {
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> lock(shard.mtx);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) return nullopt;
+        
+        shard.items.splice(shard.items.begin(), shard.items, it->second);
+        return it->second->second;
+    }
+    
+    void put(const string& key, const string& value) {
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> lock(shard.mtx);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.bytes -= charge(key, it->second->second);
+            shard.items.splice(shard.items.begin(), shard.items, it->second);
+            if (charge(key, value) > shardMaxBytes) {
+                shard.index.erase(it);
+                shard.items.pop_front();
+                return;
+            }
+            shard.items.front().second = value;
+            shard.bytes += charge(key, value);
+            evictOverflow(shard);
+            return;
+        }
+        if (charge(key, value) > shardMaxBytes) return;
+        
+        shard.items.emplace_front(key, value);
+        shard.index.emplace(shard.items.front().first, shard.items.begin());
+        shard.bytes += charge(key, value);
+        evictOverflow(shard);
+    }
+};
+
+// Camada SQLite do cache de NLP. As entradas são indexadas por 128 bits do
+// SHA-256 do texto (a entrada comprimida fica guardada para verificar
+// colisões), os valores são comprimidos com zlib e cada linha tem a data do
+// último acesso. Uma thread dedicada grava em lote, numa transação, e de
+// tempos em tempos remove o que passou do TTL ou do orçamento de tamanho,
+// devolvendo as páginas livres com incremental_vacuum. Cada thread de leitura
+// usa sua própria conexão, com o SELECT preparado uma única vez, e o banco
+// fica em modo WAL para que leitores não esperem o escritor.
+struct NLPCacheBudget {
+    uint64_t maxBytes = 256ull * 1024 * 1024;
+    chrono::seconds ttl = chrono::hours(24 * 30);
+};
+
+class NLPCacheStore {
+private:
+    using Key = array<unsigned char, 16>;
+    
+    struct Connection {
+        sqlite3* db = nullptr;
+        sqlite3_stmt* select = nullptr;
+        
+        ~Connection() {
+            sqlite3_finalize(select);
+            sqlite3_close(db);
+        }
+    };
+    
+    // Gravação pendente; sem `output`, só atualiza a data de acesso
+    struct PendingWrite {
+        string input;
+        optional<string> output;
+        int64_t accessedAt;
+    };
+    
+    static constexpr size_t WRITE_BATCH_SIZE = 256;
+    static constexpr chrono::milliseconds FLUSH_INTERVAL{200};
+    static constexpr chrono::seconds MAINTENANCE_INTERVAL{60};
+    static constexpr int EVICTION_BATCH = 500;
+    static constexpr int VACUUM_PAGES = 1000;
+    
+    const string path;
+    const NLPCacheBudget budget;
+    const uint64_t storeId;
+    bool available = false;
+    
+    mutex writeMutex;
+    condition_variable writeCv;
+    vector<PendingWrite> pendingWrites;
+    bool stopping = false;
+    thread writer;
+    
+    static uint64_t nextStoreId() {
+        static atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+    
+    static int64_t unixNow() {
+        return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+    
+    static Key keyFor(string_view input) {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        EVP_Digest(input.data(), input.size(), digest, &length, EVP_sha256(), nullptr);
+        
+        Key key;
+        copy_n(digest, key.size(), key.begin());
+        return key;
+    }
+    
+    static string compressBlob(string_view data) {
+        uLongf size = compressBound(static_cast<uLong>(data.size()));
+        string out(size, '\0');
+        if (compress2(reinterpret_cast<Bytef*>(out.data()), &size, reinterpret_cast<const Bytef*>(data.data()),
+                      static_cast<uLong>(data.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+            throw runtime_error("Erro ao comprimir entrada do cache");
+        }
+        out.resize(size);
+        return out;
+    }
+    
+    static optional<string> decompressBlob(const void* data, int size, int64_t rawSize) {
+        if (!data || rawSize < 0) return nullopt;
+        
+        string out(static_cast<size_t>(rawSize), '\0');
+        uLongf outSize = static_cast<uLongf>(rawSize);
+        if (uncompress(reinterpret_cast<Bytef*>(out.data()), &outSize, static_cast<const Bytef*>(data),
+                       static_cast<uLong>(size)) != Z_OK || outSize != static_cast<uLongf>(rawSize)) {
+            return nullopt;
+        }
+        return out;
+    }
+    
+    static sqlite3* openConnection(const string& path) {
+        sqlite3* db = nullptr;
+        // NOMUTEX: cada conexão é usada por uma única thread
+        int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+        if (sqlite3_open_v2(path.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+            cerr << theme.error << "Não foi possível abrir o banco de dados: " << sqlite3_errmsg(db) << COLOR_RESET << endl;
+            sqlite3_close(db);
+            return nullptr;
+        }
+        sqlite3_busy_timeout(db, 5000);
+        return db;
+    }
+    
+    static int64_t queryInt(sqlite3* db, const char* sql) {
+        sqlite3_stmt* stmt = nullptr;
+        int64_t value = 0;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+            value = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return value;
+    }
+    
+    // Cria o esquema e, se existir, migra a tabela antiga (entrada inteira
+    // como chave, sem compressão) para o formato novo
+    bool initializeSchema(sqlite3* db) {
+        // auto_vacuum só vale para tabelas novas ou depois de um VACUUM
+        bool needsVacuum = queryInt(db, "PRAGMA auto_vacuum") != 2;
+        sqlite3_exec(db, "PRAGMA auto_vacuum=INCREMENTAL", nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "PRAGMA synchronous=NORMAL", nullptr, nullptr, nullptr);
+        
+        const char* schema =
+            "CREATE TABLE IF NOT EXISTS nlp_cache_v2 ("
+            " key BLOB PRIMARY KEY,"
+            " input BLOB NOT NULL,"
+            " input_size INTEGER NOT NULL,"
+            " output BLOB NOT NULL,"
+            " output_size INTEGER NOT NULL,"
+            " stored_bytes INTEGER NOT NULL,"
+            " accessed_at INTEGER NOT NULL);"
+            "CREATE INDEX IF NOT EXISTS nlp_cache_v2_accessed ON nlp_cache_v2 (accessed_at);";
+        if (sqlite3_exec(db, schema, nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << theme.error << "Erro ao criar tabela do cache NLP: " << sqlite3_errmsg(db) << COLOR_RESET << endl;
+            return false;
+        }
+        
+        if (queryInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'nlp_cache'") > 0) {
+            sqlite3_stmt* select = nullptr;
+            sqlite3_stmt* insert = nullptr;
+            sqlite3_prepare_v2(db, "SELECT input, output FROM nlp_cache", -1, &select, nullptr);
+            sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO nlp_cache_v2 VALUES (?, ?, ?, ?, ?, ?, ?)", -1, &insert, nullptr);
+            
+            size_t migrated = 0;
+            int64_t now = unixNow();
+            sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+            while (select && insert && sqlite3_step(select) == SQLITE_ROW) {
+                const char* input = reinterpret_cast<const char*>(sqlite3_column_text(select, 0));
+                const char* output = reinterpret_cast<const char*>(sqlite3_column_text(select, 1));
+                if (!input || !output) continue;
+                
+                string_view inputView(input, static_cast<size_t>(sqlite3_column_bytes(select, 0)));
+                string_view outputView(output, static_cast<size_t>(sqlite3_column_bytes(select, 1)));
+                bindEntry(insert, inputView, outputView, now);
+                if (sqlite3_step(insert) == SQLITE_DONE) ++migrated;
+                sqlite3_reset(insert);
+            }
+            sqlite3_finalize(select);
+            sqlite3_finalize(insert);
+            
+            if (sqlite3_exec(db, "DROP TABLE nlp_cache; COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+                cerr << theme.error << "Erro ao migrar cache NLP: " << sqlite3_errmsg(db) << COLOR_RESET << endl;
+                sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+                return false;
+            }
+            cout << theme.success << "Cache NLP migrado: " << migrated << " entradas" << COLOR_RESET << endl;
+            needsVacuum = true;
+        }
+        
+        if (needsVacuum) {
+            sqlite3_exec(db, "VACUUM", nullptr, nullptr, nullptr);
+        }
+        return true;
+    }
+    
+    static void bindEntry(sqlite3_stmt* insert, string_view input, string_view output, int64_t accessedAt) {
+        Key key = keyFor(input);
+        string compressedInput = compressBlob(input);
+        string compressedOutput = compressBlob(output);
+        
+        sqlite3_bind_blob(insert, 1, key.data(), static_cast<int>(key.size()), SQLITE_TRANSIENT);
+        sqlite3_bind_blob(insert, 2, compressedInput.data(), static_cast<int>(compressedInput.size()), SQLITE_TRANSIENT);
+        sqlite3_bind_int64(insert, 3, static_cast<int64_t>(input.size()));
+        sqlite3_bind_blob(insert, 4, compressedOutput.data(), static_cast<int>(compressedOutput.size()), SQLITE_TRANSIENT);
+        sqlite3_bind_int64(insert, 5, static_cast<int64_t>(output.size()));
+        sqlite3_bind_int64(insert, 6, static_cast<int64_t>(key.size() + compressedInput.size() + compressedOutput.size()));
+        sqlite3_bind_int64(insert, 7, accessedAt);
+    }
+    
+    // Conexão da thread atual, aberta no primeiro uso
+    Connection* connection() {
+        thread_local unordered_map<uint64_t, unique_ptr<Connection>> connections;
+        
+        auto& conn = connections[storeId];
+        if (!conn) {
+            conn = make_unique<Connection>();
+            conn->db = openConnection(path);
+            if (conn->db) {
+                const char* sql = "SELECT input, input_size, output, output_size FROM nlp_cache_v2 WHERE key = ?";
+                sqlite3_prepare_v2(conn->db, sql, -1, &conn->select, nullptr);
+            }
+        }
+        return conn->select ? conn.get() : nullptr;
+    }
+    
+    void flush(sqlite3* db, sqlite3_stmt* insert, sqlite3_stmt* touch, vector<PendingWrite>& batch) {
+        if (batch.empty()) return;
+        
+        sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+        for (const auto& write : batch) {
+            try {
+                if (write.output) {
+                    bindEntry(insert, write.input, *write.output, write.accessedAt);
+                    sqlite3_step(insert);
+                    sqlite3_reset(insert);
+                } else {
+                    Key key = keyFor(write.input);
+                    sqlite3_bind_int64(touch, 1, write.accessedAt);
+                    sqlite3_bind_blob(touch, 2, key.data(), static_cast<int>(key.size()), SQLITE_TRANSIENT);
+                    sqlite3_step(touch);
+                    sqlite3_reset(touch);
+                }
+            } catch (const exception& e) {
+                cerr << theme.error << e.what() << COLOR_RESET << endl;
+            }
+        }
+        if (sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << theme.error << "Erro ao gravar cache NLP: " << sqlite3_errmsg(db) << COLOR_RESET << endl;
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+        }
+        batch.clear();
+    }
+    
+    // Remove entradas vencidas e, se o banco passou do orçamento, as menos
+    // acessadas; tudo em lotes pequenos para não segurar o lock de escrita
+    void evict(sqlite3* db) {
+        sqlite3_stmt* expire = nullptr;
+        sqlite3_prepare_v2(db,
+            "DELETE FROM nlp_cache_v2 WHERE key IN "
+            "(SELECT key FROM nlp_cache_v2 WHERE accessed_at < ? LIMIT ?)", -1, &expire, nullptr);
+        if (expire) {
+            int64_t cutoff = unixNow() - budget.ttl.count();
+            do {
+                sqlite3_bind_int64(expire, 1, cutoff);
+                sqlite3_bind_int(expire, 2, EVICTION_BATCH);
+                sqlite3_step(expire);
+                sqlite3_reset(expire);
+            } while (sqlite3_changes(db) == EVICTION_BATCH);
+            sqlite3_finalize(expire);
+        }
+        
+        int64_t total = queryInt(db, "SELECT COALESCE(SUM(stored_bytes), 0) FROM nlp_cache_v2");
+        sqlite3_stmt* oldest = nullptr;
+        sqlite3_stmt* deleteEntry = nullptr;
+        sqlite3_prepare_v2(db, "SELECT key, stored_bytes FROM nlp_cache_v2 ORDER BY accessed_at LIMIT ?", -1, &oldest, nullptr);
+        sqlite3_prepare_v2(db, "DELETE FROM nlp_cache_v2 WHERE key = ?", -1, &deleteEntry, nullptr);
+        while (oldest && deleteEntry && total > static_cast<int64_t>(budget.maxBytes)) {
+            vector<pair<string, int64_t>> victims;
+            sqlite3_bind_int(oldest, 1, EVICTION_BATCH);
+            while (sqlite3_step(oldest) == SQLITE_ROW) {
+                const char* key = static_cast<const char*>(sqlite3_column_blob(oldest, 0));
+                victims.emplace_back(string(key, static_cast<size_t>(sqlite3_column_bytes(oldest, 0))),
+                                     sqlite3_column_int64(oldest, 1));
+            }
+            sqlite3_reset(oldest);
+            if (victims.empty()) break;
+            
+            sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+            for (const auto& [key, storedBytes] : victims) {
+                if (total <= static_cast<int64_t>(budget.maxBytes)) break;
+                sqlite3_bind_blob(deleteEntry, 1, key.data(), static_cast<int>(key.size()), SQLITE_STATIC);
+                sqlite3_step(deleteEntry);
+                sqlite3_reset(deleteEntry);
+                total -= storedBytes;
+            }
+            sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+        }
+        sqlite3_finalize(oldest);
+        sqlite3_finalize(deleteEntry);
+        
+        string vacuum = "PRAGMA incremental_vacuum(" + to_string(VACUUM_PAGES) + ")";
+        sqlite3_exec(db, vacuum.c_str(), nullptr, nullptr, nullptr);
+    }
+    
+    void writerLoop() {
+        Connection conn;
+        conn.db = openConnection(path);
+        sqlite3_stmt* insert = nullptr;
+        sqlite3_stmt* touch = nullptr;
+        if (conn.db) {
+            sqlite3_prepare_v2(conn.db, "INSERT OR REPLACE INTO nlp_cache_v2 VALUES (?, ?, ?, ?, ?, ?, ?)", -1, &insert, nullptr);
+            sqlite3_prepare_v2(conn.db, "UPDATE nlp_cache_v2 SET accessed_at = ? WHERE key = ?", -1, &touch, nullptr);
+        }
+        if (!insert || !touch) {
+            cerr << theme.error << "Cache NLP sem gravação em disco" << COLOR_RESET << endl;
+        }
+        
+        vector<PendingWrite> batch;
+        auto nextMaintenance = chrono::steady_clock::now();
+        unique_lock<mutex> lock(writeMutex);
+        while (true) {
+            writeCv.wait_for(lock, FLUSH_INTERVAL, [this] {
+                return stopping || pendingWrites.size() >= WRITE_BATCH_SIZE;
+            });
+            batch.swap(pendingWrites);
+            bool done = stopping;
+            
+            lock.unlock();
+            if (insert && touch) {
+                flush(conn.db, insert, touch, batch);
+                if (!done && chrono::steady_clock::now() >= nextMaintenance) {
+                    evict(conn.db);
+                    nextMaintenance = chrono::steady_clock::now() + MAINTENANCE_INTERVAL;
+                }
+            } else {
+                batch.clear();
+            }
+            lock.lock();
+            
+            if (done && pendingWrites.empty()) break;
+        }
+        sqlite3_finalize(insert);
+        sqlite3_finalize(touch);
+    }
+    
+    void enqueue(PendingWrite write) {
+        bool fullBatch;
+        {
+            lock_guard<mutex> lock(writeMutex);
+            pendingWrites.push_back(move(write));
+            fullBatch = pendingWrites.size() >= WRITE_BATCH_SIZE;
+        }
+        if (fullBatch) writeCv.notify_one();
+    }
+    
+public:
+    explicit NLPCacheStore(string path, NLPCacheBudget budget = {})
+        : path(move(path)), budget(budget), storeId(nextStoreId()) {
+        sqlite3* db = openConnection(this->path);
+        if (db) {
+            available = initializeSchema(db);
+            sqlite3_close(db);
+        }
+        
+        if (available) {
+            writer = thread([this] { writerLoop(); });
+        }
+    }
+    
+    ~NLPCacheStore() {
+        {
+            lock_guard<mutex> lock(writeMutex);
+            stopping = true;
+        }
+        writeCv.notify_all();
+        if (writer.joinable()) writer.join();
+    }
+    
+    NLPCacheStore(const NLPCacheStore&) = delete;
+    NLPCacheStore& operator=(const NLPCacheStore&) = delete;
+    
+    optional<string> lookup(const string& input) {
+        if (!available) return nullopt;
+        Connection* conn = connection();
+        if (!conn) return nullopt;
+        
+        Key key = keyFor(input);
+        optional<string> result;
+        sqlite3_bind_blob(conn->select, 1, key.data(), static_cast<int>(key.size()), SQLITE_STATIC);
+        if (sqlite3_step(conn->select) == SQLITE_ROW) {
+            // Confere a entrada guardada: dois textos podem ter o mesmo hash
+            auto storedInput = decompressBlob(sqlite3_column_blob(conn->select, 0), sqlite3_column_bytes(conn->select, 0),
+                                              sqlite3_column_int64(conn->select, 1));
+            if (storedInput && *storedInput == input) {
+                result = decompressBlob(sqlite3_column_blob(conn->select, 2), sqlite3_column_bytes(conn->select, 2),
+                                        sqlite3_column_int64(conn->select, 3));
+            }
+        }
+        sqlite3_reset(conn->select);
+        sqlite3_clear_bindings(conn->select);
+        
+        if (result) enqueue({input, nullopt, unixNow()});
+        return result;
+    }
+    
+    // Enfileira a gravação; ela vai para o disco no próximo lote
+    void store(string input, string output) {
+        if (!available) return;
+        enqueue({move(input), move(output), unixNow()});
+    }
+};
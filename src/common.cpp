@@ -0,0 +1,6 @@
+// common.cpp - Estado global compartilhado
+#include "common.h"
+
+Theme theme;
+
+const chrono::steady_clock::time_point processStart = chrono::steady_clock::now();
@@ -0,0 +1,65 @@
+// common.h - Includes, tema do terminal e utilitários compartilhados
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <deque>
+#include <list>
+#include <array>
+#include <atomic>
+#include <string_view>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <memory_resource>
+#include <ctime>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <optional>
+#include <chrono>
+#include <functional>
+#include <climits>
+#include <cstring>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+using namespace std;
+using json = nlohmann::json;
+
+// Constantes de cores ANSI para terminal
+const string COLOR_RESET = "\033[0m";
+const string COLOR_BLUE = "\033[34m";
+const string COLOR_GREEN = "\033[32m";
+const string COLOR_YELLOW = "\033[33m";
+const string COLOR_RED = "\033[31m";
+const string COLOR_CYAN = "\033[36m";
+const string COLOR_MAGENTA = "\033[35m";
+const string BG_BLUE = "\033[44m";
+const string BG_GREEN = "\033[42m";
+const string BG_DARK = "\033[48;5;234m";
+
+// Configuração de tema
+struct Theme {
+    string primary = COLOR_CYAN;
+    string secondary = COLOR_GREEN;
+    string accent = COLOR_MAGENTA;
+    string background = BG_DARK;
+    string text = "\033[37m";
+    string error = COLOR_RED;
+    string warning = COLOR_YELLOW;
+    string success = COLOR_GREEN;
+};
+
+extern Theme theme;
+
+
+// Instante em que o processo começou, para o log de tempos de inicialização
+extern const chrono::steady_clock::time_point processStart;
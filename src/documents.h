@@ -0,0 +1,900 @@
+// documents.h - Geração de PPTX/XLSX em streaming
+#pragma once
+
+#include "common.h"
+#include "telemetry.h"
+#include "worker_pool.h"
+#include <zlib.h>
+#include <libxml/parser.h>  // Processamento XML para PPTX/XLSX
+
+// Destino dos bytes de um arquivo gerado; retornar false aborta a geração
+using ByteSink = function<bool(const char*, size_t)>;
+
+// Conteúdo já comprimido em deflate "raw", com o CRC e o tamanho originais,
+// pronto para ser copiado byte a byte para dentro de um ZIP
+struct PrecompressedPart {
+    string deflated;
+    uint32_t crc = 0;
+    uint64_t size = 0;
+    
+    static PrecompressedPart compress(string_view content, int level = Z_BEST_COMPRESSION) {
+        PrecompressedPart part;
+        part.size = content.size();
+        part.crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(content.data()),
+                         static_cast<uInt>(content.size()));
+        
+        z_stream zs{};
+        if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw runtime_error("Erro ao inicializar o zlib");
+        }
+        part.deflated.resize(deflateBound(&zs, static_cast<uLong>(content.size())));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+        zs.avail_in = static_cast<uInt>(content.size());
+        zs.next_out = reinterpret_cast<Bytef*>(part.deflated.data());
+        zs.avail_out = static_cast<uInt>(part.deflated.size());
+        static auto& zipStage = stageHistogram("zip");
+        auto started = chrono::steady_clock::now();
+        int ret = deflate(&zs, Z_FINISH);
+        zipStage.record(chrono::steady_clock::now() - started);
+        part.deflated.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END) {
+            throw runtime_error("Erro ao comprimir parte do pacote");
+        }
+        return part;
+    }
+};
+
+// Escreve um ZIP sequencialmente, sem seek: cada entrada é comprimida à medida
+// que os dados chegam e os tamanhos/CRC vão num data descriptor após os dados.
+// Partes já comprimidas (PrecompressedPart) são copiadas sem passar pelo zlib.
+// A memória usada é limitada ao estado do zlib mais um buffer de saída fixo,
+// independente do tamanho das entradas. Não suporta ZIP64 (>4 GiB ou >65535
+// entradas).
+class ZipStreamWriter {
+private:
+    struct Entry {
+        string path;
+        uint16_t flags = 0;
+        uint32_t crc = 0;
+        uint64_t compressedSize = 0;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+    };
+    
+    static constexpr size_t OUT_BUFFER_SIZE = 64 * 1024;
+    static constexpr uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
+    static constexpr uint16_t FLAG_UTF8 = 0x0800;
+    
+    ByteSink sink;
+    z_stream zs{};
+    bool zsReady = false;
+    bool inEntry = false;
+    bool failed = false;
+    vector<Entry> entries;
+    vector<char> outBuffer;
+    uint64_t offset = 0;
+    // Data/hora fixa (1980-01-01 00:00, formato MS-DOS): as mesmas entradas
+    // produzem sempre os mesmos bytes, o que permite cache e ETag
+    static constexpr uint16_t dosTime = 0;
+    static constexpr uint16_t dosDate = (1 << 5) | 1;
+    
+    static void putLE16(string& out, uint16_t v) {
+        out += static_cast<char>(v & 0xff);
+        out += static_cast<char>((v >> 8) & 0xff);
+    }
+    
+    static void putLE32(string& out, uint32_t v) {
+        putLE16(out, static_cast<uint16_t>(v & 0xffff));
+        putLE16(out, static_cast<uint16_t>(v >> 16));
+    }
+    
+    string localHeader(const Entry& entry) const {
+        string header;
+        putLE32(header, 0x04034b50);
+        putLE16(header, 20);
+        putLE16(header, entry.flags);
+        putLE16(header, Z_DEFLATED);
+        putLE16(header, dosTime);
+        putLE16(header, dosDate);
+        putLE32(header, entry.crc);
+        putLE32(header, static_cast<uint32_t>(entry.compressedSize));
+        putLE32(header, static_cast<uint32_t>(entry.size));
+        putLE16(header, static_cast<uint16_t>(entry.path.size()));
+        putLE16(header, 0);
+        header += entry.path;
+        return header;
+    }
+    
+    bool emit(const char* data, size_t size) {
+        if (failed) return false;
+        if (size > 0 && !sink(data, size)) {
+            failed = true;
+            return false;
+        }
+        offset += size;
+        return true;
+    }
+    
+    bool emit(string_view data) {
+        return emit(data.data(), data.size());
+    }
+    
+    // Alimenta o zlib e despeja no sink tudo o que ele produzir
+    bool pump(const char* data, size_t size, int flush) {
+        Entry& entry = entries.back();
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        zs.avail_in = static_cast<uInt>(size);
+        
+        // Só o tempo dentro do zlib conta como "zip"; o sink pode ser a rede
+        static auto& zipStage = stageHistogram("zip");
+        chrono::steady_clock::duration deflating{};
+        
+        int ret;
+        do {
+            zs.next_out = reinterpret_cast<Bytef*>(outBuffer.data());
+            zs.avail_out = static_cast<uInt>(outBuffer.size());
+            auto started = chrono::steady_clock::now();
+            ret = deflate(&zs, flush);
+            deflating += chrono::steady_clock::now() - started;
+            if (ret == Z_STREAM_ERROR) {
+                failed = true;
+                return false;
+            }
+            size_t produced = outBuffer.size() - zs.avail_out;
+            entry.compressedSize += produced;
+            if (!emit(outBuffer.data(), produced)) {
+                zipStage.record(deflating);
+                return false;
+            }
+        } while (zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+        
+        zipStage.record(deflating);
+        return true;
+    }
+    
+public:
+    explicit ZipStreamWriter(ByteSink sink) : sink(move(sink)), outBuffer(OUT_BUFFER_SIZE) {}
+    
+    ~ZipStreamWriter() {
+        if (zsReady) deflateEnd(&zs);
+    }
+    
+    ZipStreamWriter(const ZipStreamWriter&) = delete;
+    ZipStreamWriter& operator=(const ZipStreamWriter&) = delete;
+    
+    bool beginEntry(const string& path) {
+        if (failed || inEntry || entries.size() >= 0xffff) return false;
+        
+        if (!zsReady) {
+            // windowBits negativo: deflate "raw", sem cabeçalho zlib, como o ZIP exige
+            if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                failed = true;
+                return false;
+            }
+            zsReady = true;
+        } else {
+            deflateReset(&zs);
+        }
+        
+        Entry entry;
+        entry.path = path;
+        entry.flags = FLAG_DATA_DESCRIPTOR | FLAG_UTF8;
+        entry.crc = crc32(0L, Z_NULL, 0);
+        entry.offset = offset;
+        entries.push_back(move(entry));
+        inEntry = true;
+        
+        // Cabeçalho local; CRC e tamanhos vão no data descriptor
+        return emit(localHeader(entries.back()));
+    }
+    
+    bool write(const char* data, size_t size) {
+        if (failed || !inEntry) return false;
+        if (size == 0) return true;
+        
+        Entry& entry = entries.back();
+        entry.crc = crc32(entry.crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size));
+        entry.size += size;
+        return pump(data, size, Z_NO_FLUSH);
+    }
+    
+    bool write(string_view data) {
+        return write(data.data(), data.size());
+    }
+    
+    bool endEntry() {
+        if (failed || !inEntry) return false;
+        if (!pump(nullptr, 0, Z_FINISH)) return false;
+        inEntry = false;
+        
+        const Entry& entry = entries.back();
+        if (entry.size > 0xffffffffULL || entry.compressedSize > 0xffffffffULL) {
+            failed = true;
+            return false;
+        }
+        
+        string descriptor;
+        putLE32(descriptor, 0x08074b50);
+        putLE32(descriptor, entry.crc);
+        putLE32(descriptor, static_cast<uint32_t>(entry.compressedSize));
+        putLE32(descriptor, static_cast<uint32_t>(entry.size));
+        return emit(descriptor);
+    }
+    
+    bool addFile(const string& path, string_view content) {
+        return beginEntry(path) && write(content) && endEntry();
+    }
+    
+    // Copia uma parte já comprimida; CRC e tamanhos vão direto no cabeçalho local
+    bool addPrecompressed(const string& path, const PrecompressedPart& part) {
+        if (failed || inEntry || entries.size() >= 0xffff) return false;
+        if (part.size > 0xffffffffULL || part.deflated.size() > 0xffffffffULL) return false;
+        
+        Entry entry;
+        entry.path = path;
+        entry.flags = FLAG_UTF8;
+        entry.crc = part.crc;
+        entry.compressedSize = part.deflated.size();
+        entry.size = part.size;
+        entry.offset = offset;
+        entries.push_back(move(entry));
+        
+        return emit(localHeader(entries.back())) && emit(part.deflated);
+    }
+    
+    // Escreve o diretório central; depois disso o arquivo está completo
+    bool finish() {
+        if (failed || inEntry) return false;
+        TraceSpan span("zip_finish");
+        
+        uint64_t directoryOffset = offset;
+        string directory;
+        for (const auto& entry : entries) {
+            putLE32(directory, 0x02014b50);
+            putLE16(directory, 20);
+            putLE16(directory, 20);
+            putLE16(directory, entry.flags);
+            putLE16(directory, Z_DEFLATED);
+            putLE16(directory, dosTime);
+            putLE16(directory, dosDate);
+            putLE32(directory, entry.crc);
+            putLE32(directory, static_cast<uint32_t>(entry.compressedSize));
+            putLE32(directory, static_cast<uint32_t>(entry.size));
+            putLE16(directory, static_cast<uint16_t>(entry.path.size()));
+            putLE16(directory, 0);
+            putLE16(directory, 0);
+            putLE16(directory, 0);
+            putLE16(directory, 0);
+            putLE32(directory, 0);
+            putLE32(directory, static_cast<uint32_t>(entry.offset));
+            directory += entry.path;
+        }
+        
+        uint64_t directorySize = directory.size();
+        if (directoryOffset > 0xffffffffULL || directorySize > 0xffffffffULL) {
+            failed = true;
+            return false;
+        }
+        
+        putLE32(directory, 0x06054b50);
+        putLE16(directory, 0);
+        putLE16(directory, 0);
+        putLE16(directory, static_cast<uint16_t>(entries.size()));
+        putLE16(directory, static_cast<uint16_t>(entries.size()));
+        putLE32(directory, static_cast<uint32_t>(directorySize));
+        putLE32(directory, static_cast<uint32_t>(directoryOffset));
+        putLE16(directory, 0);
+        return emit(directory);
+    }
+};
+
+// Esqueletos dos pacotes PPTX/XLSX: as partes que não mudam entre documentos
+// são comprimidas uma única vez (na primeira chamada a get(), feita pelo
+// FileGenerator na inicialização) e depois só copiadas para cada arquivo.
+class PackageTemplates {
+public:
+    using Parts = vector<pair<string, PrecompressedPart>>;
+    
+    Parts pptxParts;
+    Parts xlsxParts;
+    PrecompressedPart slideRels;  // idêntico para todos os slides
+    
+    static const PackageTemplates& get() {
+        static const PackageTemplates templates;
+        return templates;
+    }
+    
+    // Trechos fixos do XML dos slides; só o texto muda por requisição
+    static constexpr string_view SLIDE_HEADER = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<p:sld xmlns:a="http://schemas.openxmlformats.org/drawingml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships" xmlns:p="http://schemas.openxmlformats.org/presentationml/2006/main">
+  <p:cSld>
+    <p:spTree>
+      <p:nvGrpSpPr><p:cNvPr id="1" name=""/><p:cNvGrpSpPr/><p:nvPr/></p:nvGrpSpPr>
+      <p:grpSpPr/>
+      <p:sp>
+        <p:nvSpPr><p:cNvPr id="2" name="Texto"/><p:cNvSpPr txBox="1"/><p:nvPr/></p:nvSpPr>
+        <p:spPr>
+          <a:xfrm><a:off x="838200" y="2743200"/><a:ext cx="10515600" cy="1371600"/></a:xfrm>
+          <a:prstGeom prst="rect"><a:avLst/></a:prstGeom>
+        </p:spPr>
+        <p:txBody>
+          <a:bodyPr/>
+          <a:lstStyle/>
+          <a:p>
+            <a:r>
+              <a:rPr lang="pt-BR" sz="3200"/>
+              <a:t>)";
+    
+    static constexpr string_view SLIDE_FOOTER = R"(</a:t>
+            </a:r>
+          </a:p>
+        </p:txBody>
+      </p:sp>
+    </p:spTree>
+  </p:cSld>
+  <p:clrMapOvr><a:masterClrMapping/></p:clrMapOvr>
+</p:sld>)";
+    
+    static constexpr string_view PPTX_CONTENT_TYPES_HEADER = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Types xmlns="http://schemas.openxmlformats.org/package/2006/content-types">
+  <Default Extension="xml" ContentType="application/xml"/>
+  <Default Extension="rels" ContentType="application/vnd.openxmlformats-package.relationships+xml"/>
+  <Override PartName="/ppt/presentation.xml" ContentType="application/vnd.openxmlformats-officedocument.presentationml.presentation.main+xml"/>
+  <Override PartName="/ppt/slideMasters/slideMaster1.xml" ContentType="application/vnd.openxmlformats-officedocument.presentationml.slideMaster+xml"/>
+  <Override PartName="/ppt/slideLayouts/slideLayout1.xml" ContentType="application/vnd.openxmlformats-officedocument.presentationml.slideLayout+xml"/>
+  <Override PartName="/ppt/theme/theme1.xml" ContentType="application/vnd.openxmlformats-officedocument.theme+xml"/>)";
+    
+    static constexpr string_view PRESENTATION_HEADER = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<p:presentation xmlns:a="http://schemas.openxmlformats.org/drawingml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships" xmlns:p="http://schemas.openxmlformats.org/presentationml/2006/main">
+  <p:sldMasterIdLst>
+    <p:sldMasterId id="2147483648" r:id="rId1"/>
+  </p:sldMasterIdLst>
+  <p:sldIdLst>)";
+    
+    static constexpr string_view PRESENTATION_FOOTER = R"(
+  </p:sldIdLst>
+  <p:sldSz cx="12192000" cy="6858000"/>
+  <p:notesSz cx="6858000" cy="9144000"/>
+</p:presentation>)";
+    
+    static constexpr string_view PRESENTATION_RELS_HEADER = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">
+  <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/slideMaster" Target="slideMasters/slideMaster1.xml"/>
+  <Relationship Id="rId2" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/theme" Target="theme/theme1.xml"/>)";
+    
+    // Os slides começam em rId3 na lista de relacionamentos da apresentação
+    static constexpr size_t FIRST_SLIDE_REL_ID = 3;
+    
+private:
+    PackageTemplates() {
+        auto add = [](Parts& parts, string path, string_view content) {
+            parts.emplace_back(move(path), PrecompressedPart::compress(content));
+        };
+        
+        add(pptxParts, "_rels/.rels", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">
+  <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="ppt/presentation.xml"/>
+</Relationships>)");
+        
+        add(pptxParts, "ppt/slideMasters/slideMaster1.xml", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<p:sldMaster xmlns:a="http://schemas.openxmlformats.org/drawingml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships" xmlns:p="http://schemas.openxmlformats.org/presentationml/2006/main">
+  <p:cSld>
+    <p:spTree>
+      <p:nvGrpSpPr><p:cNvPr id="1" name=""/><p:cNvGrpSpPr/><p:nvPr/></p:nvGrpSpPr>
+      <p:grpSpPr/>
+    </p:spTree>
+  </p:cSld>
+  <p:clrMap bg1="lt1" tx1="dk1" bg2="lt2" tx2="dk2" accent1="accent1" accent2="accent2" accent3="accent3" accent4="accent4" accent5="accent5" accent6="accent6" hlink="hlink" folHlink="folHlink"/>
+  <p:sldLayoutIdLst>
+    <p:sldLayoutId id="2147483649" r:id="rId1"/>
+  </p:sldLayoutIdLst>
+</p:sldMaster>)");
+        
+        add(pptxParts, "ppt/slideMasters/_rels/slideMaster1.xml.rels", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">
+  <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/slideLayout" Target="../slideLayouts/slideLayout1.xml"/>
+  <Relationship Id="rId2" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/theme" Target="../theme/theme1.xml"/>
+</Relationships>)");
+        
+        add(pptxParts, "ppt/slideLayouts/slideLayout1.xml", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<p:sldLayout xmlns:a="http://schemas.openxmlformats.org/drawingml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships" xmlns:p="http://schemas.openxmlformats.org/presentationml/2006/main" type="blank" preserve="1">
+  <p:cSld name="Em branco">
+    <p:spTree>
+      <p:nvGrpSpPr><p:cNvPr id="1" name=""/><p:cNvGrpSpPr/><p:nvPr/></p:nvGrpSpPr>
+      <p:grpSpPr/>
+    </p:spTree>
+  </p:cSld>
+  <p:clrMapOvr><a:masterClrMapping/></p:clrMapOvr>
+</p:sldLayout>)");
+        
+        add(pptxParts, "ppt/slideLayouts/_rels/slideLayout1.xml.rels", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">
+  <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/slideMaster" Target="../slideMasters/slideMaster1.xml"/>
+</Relationships>)");
+        
+        add(pptxParts, "ppt/theme/theme1.xml", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<a:theme xmlns:a="http://schemas.openxmlformats.org/drawingml/2006/main" name="Paulo Roberto">
+  <a:themeElements>
+    <a:clrScheme name="Paulo Roberto">
+      <a:dk1><a:sysClr val="windowText" lastClr="000000"/></a:dk1>
+      <a:lt1><a:sysClr val="window" lastClr="FFFFFF"/></a:lt1>
+      <a:dk2><a:srgbClr val="1A1A1A"/></a:dk2>
+      <a:lt2><a:srgbClr val="E7E6E6"/></a:lt2>
+      <a:accent1><a:srgbClr val="00FFFF"/></a:accent1>
+      <a:accent2><a:srgbClr val="00FF00"/></a:accent2>
+      <a:accent3><a:srgbClr val="0066CC"/></a:accent3>
+      <a:accent4><a:srgbClr val="FF00FF"/></a:accent4>
+      <a:accent5><a:srgbClr val="FFC000"/></a:accent5>
+      <a:accent6><a:srgbClr val="70AD47"/></a:accent6>
+      <a:hlink><a:srgbClr val="0563C1"/></a:hlink>
+      <a:folHlink><a:srgbClr val="954F72"/></a:folHlink>
+    </a:clrScheme>
+    <a:fontScheme name="Paulo Roberto">
+      <a:majorFont><a:latin typeface="Calibri Light"/><a:ea typeface=""/><a:cs typeface=""/></a:majorFont>
+      <a:minorFont><a:latin typeface="Calibri"/><a:ea typeface=""/><a:cs typeface=""/></a:minorFont>
+    </a:fontScheme>
+    <a:fmtScheme name="Paulo Roberto">
+      <a:fillStyleLst>
+        <a:solidFill><a:schemeClr val="phClr"/></a:solidFill>
+        <a:solidFill><a:schemeClr val="phClr"/></a:solidFill>
+        <a:solidFill><a:schemeClr val="phClr"/></a:solidFill>
+      </a:fillStyleLst>
+      <a:lnStyleLst>
+        <a:ln w="6350"><a:solidFill><a:schemeClr val="phClr"/></a:solidFill></a:ln>
+        <a:ln w="12700"><a:solidFill><a:schemeClr val="phClr"/></a:solidFill></a:ln>
+        <a:ln w="19050"><a:solidFill><a:schemeClr val="phClr"/></a:solidFill></a:ln>
+      </a:lnStyleLst>
+      <a:effectStyleLst>
+        <a:effectStyle><a:effectLst/></a:effectStyle>
+        <a:effectStyle><a:effectLst/></a:effectStyle>
+        <a:effectStyle><a:effectLst/></a:effectStyle>
+      </a:effectStyleLst>
+      <a:bgFillStyleLst>
+        <a:solidFill><a:schemeClr val="phClr"/></a:solidFill>
+        <a:solidFill><a:schemeClr val="phClr"/></a:solidFill>
+        <a:solidFill><a:schemeClr val="phClr"/></a:solidFill>
+      </a:bgFillStyleLst>
+    </a:fmtScheme>
+  </a:themeElements>
+</a:theme>)");
+        
+        slideRels = PrecompressedPart::compress(R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">
+  <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/slideLayout" Target="../slideLayouts/slideLayout1.xml"/>
+</Relationships>)");
+        
+        add(xlsxParts, "[Content_Types].xml", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Types xmlns="http://schemas.openxmlformats.org/package/2006/content-types">
+  <Default Extension="xml" ContentType="application/xml"/>
+  <Default Extension="rels" ContentType="application/vnd.openxmlformats-package.relationships+xml"/>
+  <Override PartName="/xl/workbook.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml"/>
+  <Override PartName="/xl/worksheets/sheet1.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml"/>
+  <Override PartName="/xl/sharedStrings.xml" ContentType="application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml"/>
+</Types>)");
+        
+        add(xlsxParts, "_rels/.rels", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">
+  <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument" Target="xl/workbook.xml"/>
+</Relationships>)");
+        
+        add(xlsxParts, "xl/workbook.xml", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<workbook xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" xmlns:r="http://schemas.openxmlformats.org/officeDocument/2006/relationships">
+  <sheets>
+    <sheet name="Sheet1" sheetId="1" r:id="rId1"/>
+  </sheets>
+</workbook>)");
+        
+        add(xlsxParts, "xl/_rels/workbook.xml.rels", R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">
+  <Relationship Id="rId1" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet" Target="worksheets/sheet1.xml"/>
+  <Relationship Id="rId2" Type="http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings" Target="sharedStrings.xml"/>
+</Relationships>)");
+    }
+};
+
+// Acrescenta `text` a `out` escapando os caracteres especiais de XML. Controles
+// ASCII que o XML 1.0 não aceita (exceto tab, LF e CR) são descartados.
+void appendXmlEscaped(string& out, string_view text);
+
+// Tabela de strings compartilhadas (xl/sharedStrings.xml): cada texto distinto
+// é guardado uma única vez e as células passam a referenciá-lo pelo índice.
+class SharedStringTable {
+private:
+    deque<string> strings;  // deque: as referências não se movem ao crescer
+    unordered_map<string_view, uint32_t> index;
+    size_t references = 0;
+    size_t bytes = 0;
+    size_t maxBytes;
+    
+public:
+    // Textos + estimativa do custo de cada entrada no índice
+    static constexpr size_t ENTRY_OVERHEAD = 64;
+    
+    explicit SharedStringTable(size_t maxBytes = 16 * 1024 * 1024) : maxBytes(maxBytes) {
+        index.reserve(1024);
+    }
+    
+    // Índice do texto na tabela, ou nullopt se ele for novo e a tabela já
+    // estiver no limite; textos já guardados continuam sendo reaproveitados
+    optional<uint32_t> intern(string_view text) {
+        auto it = index.find(text);
+        if (it != index.end()) {
+            ++references;
+            return it->second;
+        }
+        if (bytes + text.size() + ENTRY_OVERHEAD > maxBytes) return nullopt;
+        
+        ++references;
+        bytes += text.size() + ENTRY_OVERHEAD;
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        strings.emplace_back(text);
+        index.emplace(strings.back(), id);
+        return id;
+    }
+    
+    size_t uniqueCount() const { return strings.size(); }
+    size_t referenceCount() const { return references; }
+    size_t byteCount() const { return bytes; }
+    const deque<string>& values() const { return strings; }
+};
+
+// Gera uma planilha XLSX linha a linha, comprimindo à medida que as linhas
+// chegam. Além da linha corrente e de um buffer de ~32 KiB, só a tabela de
+// strings distintas fica em memória, então serve para planilhas com milhões
+// de linhas de dados repetitivos. A tabela tem limite de bytes: depois dele,
+// textos novos vão direto na célula (inlineStr) e a memória para de crescer.
+class XLSXStreamWriter {
+private:
+    static constexpr size_t FLUSH_THRESHOLD = 32 * 1024;
+    
+    ZipStreamWriter zip;
+    SharedStringTable sharedStrings;
+    string buffer;
+    size_t rowCount = 0;
+    bool started = false;
+    
+    bool flushBuffer() {
+        bool ok = zip.write(buffer);
+        buffer.clear();
+        return ok;
+    }
+    
+    bool writeSharedStrings() {
+        if (!zip.beginEntry("xl/sharedStrings.xml")) return false;
+        
+        buffer = R"(<?xml version="1.0" encoding="UTF-8"?>
+<sst xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main" count=")" +
+                 to_string(sharedStrings.referenceCount()) + "\" uniqueCount=\"" +
+                 to_string(sharedStrings.uniqueCount()) + "\">";
+        for (const auto& text : sharedStrings.values()) {
+            buffer += "<si>";
+            appendTextElement(text);
+            buffer += "</si>";
+            if (buffer.size() >= FLUSH_THRESHOLD && !flushBuffer()) return false;
+        }
+        buffer += "</sst>";
+        return flushBuffer() && zip.endEntry();
+    }
+    
+    // <t> com o texto escapado; espaços nas pontas só são preservados com
+    // xml:space
+    void appendTextElement(string_view text) {
+        bool preserve = !text.empty() && (isspace(static_cast<unsigned char>(text.front())) ||
+                                          isspace(static_cast<unsigned char>(text.back())));
+        buffer += preserve ? "<t xml:space=\"preserve\">" : "<t>";
+        appendXmlEscaped(buffer, text);
+        buffer += "</t>";
+    }
+    
+public:
+    explicit XLSXStreamWriter(ByteSink sink) : zip(move(sink)) {
+        buffer.reserve(FLUSH_THRESHOLD * 2);
+    }
+    
+    // Referência de coluna no estilo do Excel: 0 -> A, 25 -> Z, 26 -> AA, ...
+    static string columnName(size_t col) {
+        string name;
+        for (size_t n = col + 1; n > 0; n = (n - 1) / 26) {
+            name.insert(name.begin(), static_cast<char>('A' + (n - 1) % 26));
+        }
+        return name;
+    }
+    
+    // Decide se a célula vira número. Textos com zero à esquerda ("007", CEP)
+    // e com mais de 15 dígitos (limite de precisão do Excel) continuam texto.
+    static bool isNumericCell(string_view text) {
+        size_t i = 0, n = text.size();
+        if (i < n && text[i] == '-') ++i;
+        
+        size_t intStart = i;
+        while (i < n && isdigit(static_cast<unsigned char>(text[i]))) ++i;
+        size_t digits = i - intStart;
+        if (digits == 0) return false;
+        if (digits > 1 && text[intStart] == '0') return false;
+        
+        if (i < n && text[i] == '.') {
+            size_t fracStart = ++i;
+            while (i < n && isdigit(static_cast<unsigned char>(text[i]))) ++i;
+            if (i == fracStart) return false;
+            digits += i - fracStart;
+        }
+        
+        if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+            ++i;
+            if (i < n && (text[i] == '+' || text[i] == '-')) ++i;
+            size_t expStart = i;
+            while (i < n && isdigit(static_cast<unsigned char>(text[i]))) ++i;
+            if (i == expStart) return false;
+        }
+        
+        return i == n && digits <= 15;
+    }
+    
+    bool begin() {
+        for (const auto& [path, part] : PackageTemplates::get().xlsxParts) {
+            if (!zip.addPrecompressed(path, part)) return false;
+        }
+        
+        started = zip.beginEntry("xl/worksheets/sheet1.xml");
+        buffer = R"(<?xml version="1.0" encoding="UTF-8"?>
+<worksheet xmlns="http://schemas.openxmlformats.org/spreadsheetml/2006/main">
+  <sheetData>)";
+        return started;
+    }
+    
+    bool addRow(const vector<string>& cells) {
+        if (!started) return false;
+        
+        string rowRef = to_string(++rowCount);
+        buffer += "<row r=\"" + rowRef + "\">";
+        for (size_t col = 0; col < cells.size(); ++col) {
+            const string& value = cells[col];
+            if (value.empty()) continue;
+            
+            buffer += "<c r=\"";
+            buffer += columnName(col);
+            buffer += rowRef;
+            if (isNumericCell(value)) {
+                buffer += "\"><v>";
+                buffer += value;
+                buffer += "</v></c>";
+            } else if (auto id = sharedStrings.intern(value)) {
+                buffer += "\" t=\"s\"><v>";
+                buffer += to_string(*id);
+                buffer += "</v></c>";
+            } else {
+                buffer += "\" t=\"inlineStr\"><is>";
+                appendTextElement(value);
+                buffer += "</is></c>";
+            }
+        }
+        buffer += "</row>";
+        
+        if (buffer.size() >= FLUSH_THRESHOLD) return flushBuffer();
+        return true;
+    }
+    
+    bool finish() {
+        if (!started) return false;
+        started = false;
+        
+        buffer += R"(
+  </sheetData>
+</worksheet>)";
+        return flushBuffer() && zip.endEntry() && writeSharedStrings() && zip.finish();
+    }
+};
+
+// Os bytes gerados entram no cache e no ETag forte pela chave do
+// ArtifactCache: mudanças na saída precisam aumentar ARTIFACT_FORMAT_VERSION
+class FileGenerator {
+private:
+    // A partir de quantos slides a compressão é distribuída pelo WorkerPool
+    size_t parallelSlideThreshold = 32;
+    static constexpr int SLIDE_COMPRESSION = Z_DEFAULT_COMPRESSION;
+    
+    string generateUUID() {
+        random_device rd;
+        mt19937 gen(rd());
+        uniform_int_distribution<> dis(0, 15);
+        
+        const char* hex_chars = "0123456789abcdef";
+        string uuid;
+        
+        for (int i = 0; i < 32; i++) {
+            if (i == 8 || i == 12 || i == 16 || i == 20) {
+                uuid += "-";
+            }
+            uuid += hex_chars[dis(gen)];
+        }
+        
+        return uuid;
+    }
+    
+    // Grava o resultado de `generate` num arquivo; remove o arquivo se falhar
+    bool writeToFile(const string& filename, const function<bool(const ByteSink&)>& generate) {
+        ofstream file(filename, ios::binary | ios::trunc);
+        if (!file) return false;
+        
+        bool ok = generate([&file](const char* bytes, size_t size) {
+            return static_cast<bool>(file.write(bytes, static_cast<streamsize>(size)));
+        });
+        file.close();
+        if (!ok || !file) {
+            remove(filename.c_str());
+            return false;
+        }
+        return true;
+    }
+    
+    bool writeToString(string& out, const function<bool(const ByteSink&)>& generate) {
+        out.clear();
+        bool ok = generate([&out](const char* bytes, size_t size) {
+            out.append(bytes, size);
+            return true;
+        });
+        if (!ok) out.clear();
+        return ok;
+    }
+    
+public:
+    FileGenerator() {
+        // Comprime os esqueletos dos pacotes já na inicialização
+        PackageTemplates::get();
+    }
+    
+    // 0 desativa a compressão paralela
+    void setParallelSlideThreshold(size_t threshold) {
+        parallelSlideThreshold = threshold;
+    }
+    
+    // Nome único para um arquivo gerado (o timestamp em segundos colidia
+    // entre requisições simultâneas)
+    string generateFilename(const string& prefix, const string& extension) {
+        return prefix + "_" + generateUUID() + extension;
+    }
+    
+    bool generatePPTX(const vector<string>& slides, const ByteSink& sink) {
+        static auto& pptxStage = stageHistogram("generate_pptx");
+        StageTimer timer(pptxStage, "generate_pptx");
+        using T = PackageTemplates;
+        const T& templates = T::get();
+        ZipStreamWriter zip(sink);
+        
+        // Partes que dependem da quantidade de slides
+        string contentTypes(T::PPTX_CONTENT_TYPES_HEADER);
+        string presentation(T::PRESENTATION_HEADER);
+        string presentationRels(T::PRESENTATION_RELS_HEADER);
+        for (size_t i = 0; i < slides.size(); ++i) {
+            string number = to_string(i + 1);
+            string relId = "rId" + to_string(T::FIRST_SLIDE_REL_ID + i);
+            contentTypes += "\n  <Override PartName=\"/ppt/slides/slide" + number +
+                            ".xml\" ContentType=\"application/vnd.openxmlformats-officedocument.presentationml.slide+xml\"/>";
+            presentation += "\n    <p:sldId id=\"" + to_string(256 + i) + "\" r:id=\"" + relId + "\"/>";
+            presentationRels += "\n  <Relationship Id=\"" + relId +
+                                "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/slide\" Target=\"slides/slide" +
+                                number + ".xml\"/>";
+        }
+        contentTypes += "\n</Types>";
+        presentation += T::PRESENTATION_FOOTER;
+        presentationRels += "\n</Relationships>";
+        
+        if (!zip.addFile("[Content_Types].xml", contentTypes)) return false;
+        for (const auto& [path, part] : templates.pptxParts) {
+            if (!zip.addPrecompressed(path, part)) return false;
+        }
+        if (!zip.addFile("ppt/presentation.xml", presentation) ||
+            !zip.addFile("ppt/_rels/presentation.xml.rels", presentationRels)) {
+            return false;
+        }
+        
+        auto buildSlide = [&slides](size_t i, string& out) {
+            out.assign(T::SLIDE_HEADER);
+            appendXmlEscaped(out, slides[i]);
+            out += T::SLIDE_FOOTER;
+        };
+        auto addSlideRels = [&](size_t i) {
+            return zip.addPrecompressed("ppt/slides/_rels/slide" + to_string(i + 1) + ".xml.rels",
+                                        templates.slideRels);
+        };
+        
+        // Os dois caminhos comprimem cada slide do mesmo jeito
+        // (PrecompressedPart, sem data descriptor): os bytes do arquivo não
+        // podem depender do número de núcleos, porque o ETag forte vem só
+        // das entradas
+        WorkerPool& pool = WorkerPool::shared();
+        if (parallelSlideThreshold == 0 || slides.size() < parallelSlideThreshold || pool.size() < 2) {
+            string slideContent;
+            for (size_t i = 0; i < slides.size(); ++i) {
+                buildSlide(i, slideContent);
+                if (!zip.addPrecompressed("ppt/slides/slide" + to_string(i + 1) + ".xml",
+                                          PrecompressedPart::compress(slideContent, SLIDE_COMPRESSION)) ||
+                    !addSlideRels(i)) {
+                    return false;
+                }
+            }
+            return zip.finish();
+        }
+        
+        // Decks grandes: os slides são comprimidos em paralelo e gravados em
+        // ordem. A janela limita quantos slides comprimidos ficam em memória.
+        const size_t window = pool.size() * 4;
+        deque<future<PrecompressedPart>> pending;
+        size_t next = 0;
+        for (size_t i = 0; i < slides.size(); ++i) {
+            while (next < slides.size() && next < i + window) {
+                pending.push_back(pool.submit([buildSlide, next, trace = Tracer::currentTrace()] {
+                    TraceContext traceContext(trace);
+                    TraceSpan span("compress_slide");
+                    string slideContent;
+                    buildSlide(next, slideContent);
+                    return PrecompressedPart::compress(slideContent, SLIDE_COMPRESSION);
+                }));
+                ++next;
+            }
+            
+            future<PrecompressedPart> task = move(pending.front());
+            pending.pop_front();
+            bool ok = false;
+            try {
+                PrecompressedPart part = task.get();
+                ok = zip.addPrecompressed("ppt/slides/slide" + to_string(i + 1) + ".xml", part) &&
+                     addSlideRels(i);
+            } catch (const exception& e) {
+                cerr << theme.error << "Erro ao comprimir slide: " << e.what() << COLOR_RESET << endl;
+            }
+            if (!ok) {
+                // Espera as tarefas em andamento: elas referenciam `slides`
+                for (auto& other : pending) other.wait();
+                return false;
+            }
+        }
+        
+        return zip.finish();
+    }
+    
+    bool generatePPTX(const string& filename, const vector<string>& slides) {
+        return writeToFile(filename, [&](const ByteSink& sink) { return generatePPTX(slides, sink); });
+    }
+    
+    bool generatePPTX(const vector<string>& slides, string& out) {
+        return writeToString(out, [&](const ByteSink& sink) { return generatePPTX(slides, sink); });
+    }
+    
+    // Produtor de linhas: preenche `row` e retorna false quando acabarem
+    using RowSource = function<bool(vector<string>& row)>;
+    
+    bool generateXLSX(const RowSource& nextRow, const ByteSink& sink) {
+        static auto& xlsxStage = stageHistogram("generate_xlsx");
+        StageTimer timer(xlsxStage, "generate_xlsx");
+        XLSXStreamWriter writer(sink);
+        if (!writer.begin()) return false;
+        
+        vector<string> row;
+        while (nextRow(row)) {
+            if (!writer.addRow(row)) return false;
+        }
+        return writer.finish();
+    }
+    
+    bool generateXLSX(const vector<vector<string>>& data, const ByteSink& sink) {
+        static auto& xlsxStage = stageHistogram("generate_xlsx");
+        StageTimer timer(xlsxStage, "generate_xlsx");
+        XLSXStreamWriter writer(sink);
+        if (!writer.begin()) return false;
+        
+        for (const auto& row : data) {
+            if (!writer.addRow(row)) return false;
+        }
+        return writer.finish();
+    }
+    
+    bool generateXLSX(const string& filename, const vector<vector<string>>& data) {
+        return writeToFile(filename, [&](const ByteSink& sink) { return generateXLSX(data, sink); });
+    }
+    
+    bool generateXLSX(const vector<vector<string>>& data, string& out) {
+        return writeToString(out, [&](const ByteSink& sink) { return generateXLSX(data, sink); });
+    }
+};
@@ -0,0 +1,147 @@
+// index_page.h - Página inicial embutida no servidor
+#pragma once
+
+#include "common.h"
+
+inline constexpr string_view INDEX_HTML = R"HTML(
+<html>
+<head>
+    <title>Paulo Roberto AI</title>
+    <style>
+        body {
+            background-color: #1a1a1a;
+            color: #00ffff;
+            font-family: Arial, sans-serif;
+            max-width: 800px;
+            margin: 0 auto;
+            padding: 20px;
+        }
+        .container {
+            background-color: #2a2a2a;
+            padding: 20px;
+            border-radius: 10px;
+            box-shadow: 0 0 10px rgba(0, 255, 255, 0.3);
+        }
+        h1 {
+            color: #00ff00;
+            text-align: center;
+        }
+        textarea {
+            width: 100%;
+            padding: 10px;
+            background-color: #333;
+            color: #fff;
+            border: 1px solid #00ffff;
+            border-radius: 5px;
+            margin-bottom: 10px;
+        }
+        button {
+            background-color: #0066cc;
+            color: white;
+            border: none;
+            padding: 10px 20px;
+            border-radius: 5px;
+            cursor: pointer;
+            font-size: 16px;
+        }
+        button:hover {
+            background-color: #0055aa;
+        }
+        #response {
+            margin-top: 20px;
+            padding: 15px;
+            background-color: #333;
+            border-radius: 5px;
+            white-space: pre-wrap;
+        }
+    </style>
+</head>
+<body>
+    <div class="container">
+        <h1>Paulo Roberto AI</h1>
+        <textarea id="input" rows="5" placeholder="Digite sua solicitação..."></textarea>
+        <button onclick="sendRequest()">Enviar</button>
+        <div id="response"></div>
+    </div>
+    <script>
+        // Seções na ordem em que aparecem, mesmo que cheguem em outra ordem
+        const SECTION_ORDER = ['command', 'text', 'sentiment', 'entities'];
+        
+        function render(responseDiv, sections) {
+            const text = SECTION_ORDER.map(name => sections[name] || '').join('');
+            responseDiv.innerHTML = text.replace(/\n/g, '<br>');
+        }
+        
+        // Lê os eventos de /api/process_stream à medida que chegam; sem
+        // suporte a streams no navegador, usa o /api/process
+        async function sendRequest() {
+            const input = document.getElementById('input').value;
+            const responseDiv = document.getElementById('response');
+            responseDiv.innerHTML = "Processando...";
+            
+            try {
+                const response = await fetch('/api/process_stream', {
+                    method: 'POST',
+                    headers: {
+                        'Content-Type': 'application/json',
+                    },
+                    body: JSON.stringify({input: input})
+                });
+                if (!response.ok || !response.body || !window.TextDecoder) {
+                    return sendRequestWhole(input, responseDiv);
+                }
+                
+                const reader = response.body.getReader();
+                const decoder = new TextDecoder();
+                const sections = {};
+                let buffer = '';
+                while (true) {
+                    const {done, value} = await reader.read();
+                    if (done) break;
+                    buffer += decoder.decode(value, {stream: true});
+                    
+                    let end;
+                    while ((end = buffer.indexOf('\n\n')) !== -1) {
+                        const frame = buffer.slice(0, end);
+                        buffer = buffer.slice(end + 2);
+                        
+                        let event = 'message';
+                        let data = '';
+                        for (const line of frame.split('\n')) {
+                            if (line.startsWith('event: ')) event = line.slice(7);
+                            else if (line.startsWith('data: ')) data += line.slice(6);
+                        }
+                        const payload = data ? JSON.parse(data) : {};
+                        if (event === 'section') {
+                            sections[payload.section] = (sections[payload.section] || '') + payload.text;
+                            render(responseDiv, sections);
+                        } else if (event === 'error') {
+                            responseDiv.innerHTML = "Erro: " + payload.error;
+                        }
+                    }
+                }
+            } catch (error) {
+                responseDiv.innerHTML = "Erro: " + error;
+            }
+        }
+        
+        function sendRequestWhole(input, responseDiv) {
+            return fetch('/api/process', {
+                method: 'POST',
+                headers: {
+                    'Content-Type': 'application/json',
+                },
+                body: JSON.stringify({input: input})
+            })
+            .then(response => response.json())
+            .then(data => {
+                responseDiv.innerHTML = data.response.replace(/\n/g, '<br>');
+            })
+            .catch(error => {
+                responseDiv.innerHTML = "Erro: " + error;
+            });
+        }
+    </script>
+</body>
+</html>
+)HTML";
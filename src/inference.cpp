@@ -0,0 +1,12 @@
+// inference.cpp - Escolha do motor de inferência
+#include "inference.h"
+
+shared_ptr<InferenceEngine> loadInferenceEngine(const string& preference, int intraOpThreads) {
+    if (preference == "onnx" || (preference == "auto" && ifstream("model.onnx"))) {
+        return make_shared<OnnxEngine>("model.onnx", intraOpThreads);
+    }
+    if (preference != "torch" && preference != "auto") {
+        throw runtime_error("Motor de inferência desconhecido: " + preference);
+    }
+    return make_shared<TorchEngine>("model.pt", intraOpThreads);
+}
@@ -0,0 +1,579 @@
+// inference.h - Motores de inferência (LibTorch, ONNX Runtime) e micro-lotes
+#pragma once
+
+#include "common.h"
+#include "text.h"
+#include <onnxruntime_cxx_api.h>  // ONNX Runtime para modelos de ML
+#include <torch/script.h>  // LibTorch para NLP
+#include <sys/mman.h>  // mmap para carregar modelos
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Parâmetros do agendador de inferência
+struct InferenceTunables {
+    size_t maxBatch = 16;                          // pedidos por forward()
+    chrono::microseconds maxWait{2000};            // espera máxima para completar um lote
+    size_t maxSequence = 128;                      // tokens por pedido (o resto é truncado)
+    size_t maxQueue = 1024;                        // pedidos pendentes antes de recusar
+    int64_t vocabularySize = 30000;                // ids de token (0 é o preenchimento)
+    int intraOpThreads = static_cast<int>(max(1u, thread::hardware_concurrency() / 2));
+    size_t workers = 1;                            // threads executando lotes no mesmo motor
+    size_t warmupRuns = 3;                         // lotes sintéticos antes de ficar pronto
+};
+
+// Métricas acumuladas desde a criação do agendador
+struct InferenceMetrics {
+    uint64_t requests = 0;
+    uint64_t batches = 0;
+    uint64_t rejected = 0;
+    size_t queueDepth = 0;
+    size_t maxBatchSize = 0;
+    double meanBatchSize = 0.0;
+    double meanQueueMicros = 0.0;
+    uint64_t maxQueueMicros = 0;
+    double meanForwardMicros = 0.0;
+};
+
+// Lote codificado para inferência: ids e máscara de atenção [rows x columns]
+// em row-major, preenchidos com 0 até o maior texto do lote
+struct InferenceBatch {
+    int64_t rows = 0;
+    int64_t columns = 0;
+    vector<int64_t> ids;
+    vector<int64_t> mask;
+    
+    // Ids pelo truque do hash (FNV-1a do token com case folding), sem vocabulário
+    static vector<int64_t> encode(string_view text, size_t maxSequence, int64_t vocabularySize) {
+        vector<int64_t> ids;
+        vector<string_view> tokens;
+        Utf8Tokenizer::tokenize(text, tokens);
+        ids.reserve(min(tokens.size(), maxSequence));
+        
+        char folded[96];
+        for (const auto& token : tokens) {
+            if (ids.size() >= maxSequence) break;
+            size_t length = foldCaseUtf8(token, folded, sizeof(folded));
+            string_view key = length != 0 ? string_view(folded, length) : token;
+            
+            uint64_t hash = 1469598103934665603ULL;
+            for (unsigned char c : key) {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            ids.push_back(1 + static_cast<int64_t>(hash % static_cast<uint64_t>(vocabularySize - 1)));
+        }
+        if (ids.empty()) ids.push_back(0);
+        return ids;
+    }
+    
+    // Reaproveita os buffers de lotes anteriores
+    void reset(size_t rowCount, size_t columnCount) {
+        rows = static_cast<int64_t>(rowCount);
+        columns = static_cast<int64_t>(columnCount);
+        ids.assign(rowCount * columnCount, 0);
+        mask.assign(rowCount * columnCount, 0);
+    }
+    
+    void setRow(size_t row, const vector<int64_t>& sequence) {
+        size_t length = min(sequence.size(), static_cast<size_t>(columns));
+        copy_n(sequence.begin(), length, ids.begin() + static_cast<ptrdiff_t>(row * columns));
+        fill_n(mask.begin() + static_cast<ptrdiff_t>(row * columns), length, 1);
+    }
+};
+
+// Motor de inferência: recebe um lote e devolve uma linha de saída por linha
+// do lote. Uma instância é compartilhada por todas as threads que executam
+// lotes, então run() precisa aceitar chamadas concorrentes.
+class InferenceEngine {
+public:
+    virtual ~InferenceEngine() = default;
+    
+    virtual string name() const = 0;
+    
+    // Chamado uma vez em cada thread antes do primeiro run()
+    virtual void prepareThread() {}
+    
+    virtual vector<vector<float>> run(const InferenceBatch& batch) = 0;
+    
+protected:
+    // Divide uma saída [rows x ...] em linhas
+    static vector<vector<float>> splitRows(const float* data, int64_t rows, size_t rowSize) {
+        vector<vector<float>> result(static_cast<size_t>(rows));
+        for (size_t row = 0; row < result.size(); ++row) {
+            result[row].assign(data + row * rowSize, data + (row + 1) * rowSize);
+        }
+        return result;
+    }
+};
+
+// Arquivo mapeado em memória (somente leitura), para carregar modelos sem
+// copiar o arquivo inteiro para um buffer antes de desserializar
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    
+    // streambuf sobre o mapeamento, com seek, para APIs que leem de istream
+    class StreamBuffer : public streambuf {
+    public:
+        StreamBuffer(const char* data, size_t size) {
+            char* begin = const_cast<char*>(data);
+            setg(begin, begin, begin + size);
+        }
+        
+    protected:
+        pos_type seekoff(off_type offset, ios_base::seekdir dir, ios_base::openmode) override {
+            char* target = (dir == ios_base::beg ? eback() : dir == ios_base::cur ? gptr() : egptr()) + offset;
+            if (target < eback() || target > egptr()) return pos_type(off_type(-1));
+            setg(eback(), target, egptr());
+            return pos_type(target - eback());
+        }
+        
+        pos_type seekpos(pos_type position, ios_base::openmode mode) override {
+            return seekoff(off_type(position), ios_base::beg, mode);
+        }
+    };
+    
+public:
+    explicit MappedFile(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw runtime_error("Não foi possível abrir " + path);
+        }
+        
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            close(fd);
+            throw runtime_error("Arquivo vazio ou inacessível: " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+        
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            throw runtime_error("Falha no mmap de " + path);
+        }
+        // O modelo é lido uma vez, do início ao fim
+        madvise(mapping, length, MADV_SEQUENTIAL | MADV_WILLNEED);
+        bytes = static_cast<const char*>(mapping);
+    }
+    
+    ~MappedFile() {
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+    }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const char* data() const {
+        return bytes;
+    }
+    
+    size_t size() const {
+        return length;
+    }
+    
+    // Passa um istream sobre o conteúdo para `fn`
+    template<typename F>
+    auto withStream(F&& fn) const {
+        StreamBuffer buffer(bytes, length);
+        istream stream(&buffer);
+        return fn(stream);
+    }
+};
+
+// Modelo TorchScript (model.pt) executado pelo LibTorch
+class TorchEngine : public InferenceEngine {
+private:
+    torch::jit::script::Module model;
+    int intraOpThreads;
+    
+public:
+    TorchEngine(const string& path, int intraOpThreads) : intraOpThreads(intraOpThreads) {
+        MappedFile file(path);
+        model = file.withStream([](istream& stream) { return torch::jit::load(stream); });
+        model.eval();
+    }
+    
+    string name() const override {
+        return "torch";
+    }
+    
+    void prepareThread() override {
+        torch::set_num_threads(intraOpThreads);
+    }
+    
+    vector<vector<float>> run(const InferenceBatch& batch) override {
+        torch::InferenceMode inferenceMode;
+        
+        // Os tensores de entrada usam os buffers do lote, sem cópia
+        auto options = torch::dtype(torch::kLong);
+        torch::Tensor ids = torch::from_blob(const_cast<int64_t*>(batch.ids.data()), {batch.rows, batch.columns}, options);
+        torch::Tensor mask = torch::from_blob(const_cast<int64_t*>(batch.mask.data()), {batch.rows, batch.columns}, options);
+        
+        torch::jit::IValue output = model.forward({ids, mask});
+        torch::Tensor logits = output.isTuple() ? output.toTuple()->elements()[0].toTensor() : output.toTensor();
+        logits = logits.to(torch::kFloat).contiguous();
+        if (logits.dim() == 0 || logits.size(0) != batch.rows) {
+            throw runtime_error("Saída do modelo não tem uma linha por pedido");
+        }
+        
+        size_t rowSize = 1;
+        for (int64_t d = 1; d < logits.dim(); ++d) rowSize *= static_cast<size_t>(logits.size(d));
+        return splitRows(logits.data_ptr<float>(), batch.rows, rowSize);
+    }
+};
+
+// Modelo ONNX (model.onnx) executado pelo ONNX Runtime na CPU. A sessão é
+// única e compartilhada (Run() é thread-safe); cada execução pega um
+// IoBinding livre do pool, com o buffer de saída já alocado do tamanho do
+// maior lote visto, para que as entradas e a saída não sejam copiadas.
+class OnnxEngine : public InferenceEngine {
+private:
+    struct Binding {
+        Ort::IoBinding binding;
+        vector<float> output;
+        
+        explicit Binding(Ort::Session& session) : binding(session) {}
+    };
+    
+    Ort::Session session{nullptr};
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    vector<string> inputNames;
+    string outputName;
+    // Largura da saída quando ela é [rows x largura]; 0 enquanto não se sabe
+    atomic<size_t> outputWidth{0};
+    
+    mutex bindingsMutex;
+    vector<unique_ptr<Binding>> idleBindings;
+    
+    static Ort::Env& environment() {
+        static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "paulo_roberto_ai");
+        return env;
+    }
+    
+    static Ort::SessionOptions sessionOptions(int intraOpThreads) {
+        Ort::SessionOptions options;
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        // Paralelismo dentro dos operadores; os lotes já vêm agrupados, então
+        // a execução do grafo em si fica sequencial
+        options.SetIntraOpNumThreads(intraOpThreads);
+        options.SetInterOpNumThreads(1);
+        options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+        options.EnableCpuMemArena();
+        options.EnableMemPattern();
+        // Sem espera ativa entre lotes: as threads de operação dormem quando a
+        // fila está vazia em vez de disputar CPU com as threads HTTP
+        options.AddConfigEntry("session.intra_op.allow_spinning", "0");
+        return options;
+    }
+    
+    unique_ptr<Binding> acquireBinding() {
+        {
+            lock_guard<mutex> lock(bindingsMutex);
+            if (!idleBindings.empty()) {
+                auto binding = move(idleBindings.back());
+                idleBindings.pop_back();
+                return binding;
+            }
+        }
+        return make_unique<Binding>(session);
+    }
+    
+    void releaseBinding(unique_ptr<Binding> binding) {
+        lock_guard<mutex> lock(bindingsMutex);
+        idleBindings.push_back(move(binding));
+    }
+    
+public:
+    OnnxEngine(const string& path, int intraOpThreads) {
+        // O ONNX Runtime copia o que precisa do buffer; o mapeamento pode ser
+        // desfeito depois de criar a sessão
+        MappedFile file(path);
+        session = Ort::Session(environment(), file.data(), file.size(), sessionOptions(intraOpThreads));
+        
+        Ort::AllocatorWithDefaultOptions allocator;
+        size_t inputCount = session.GetInputCount();
+        if (inputCount == 0 || inputCount > 2 || session.GetOutputCount() == 0) {
+            throw runtime_error("Modelo ONNX deve ter ids (e opcionalmente máscara) como entrada");
+        }
+        for (size_t i = 0; i < inputCount; ++i) {
+            char* name = session.GetInputName(i, allocator);
+            inputNames.emplace_back(name);
+            allocator.Free(name);
+        }
+        char* name = session.GetOutputName(0, allocator);
+        outputName = name;
+        allocator.Free(name);
+    }
+    
+    string name() const override {
+        return "onnx";
+    }
+    
+    vector<vector<float>> run(const InferenceBatch& batch) override {
+        auto binding = acquireBinding();
+        
+        const int64_t inputShape[] = {batch.rows, batch.columns};
+        const size_t inputSize = batch.ids.size();
+        Ort::Value ids = Ort::Value::CreateTensor<int64_t>(memoryInfo, const_cast<int64_t*>(batch.ids.data()),
+                                                           inputSize, inputShape, 2);
+        Ort::Value mask = Ort::Value::CreateTensor<int64_t>(memoryInfo, const_cast<int64_t*>(batch.mask.data()),
+                                                            inputSize, inputShape, 2);
+        binding->binding.BindInput(inputNames[0].c_str(), ids);
+        if (inputNames.size() > 1) binding->binding.BindInput(inputNames[1].c_str(), mask);
+        
+        // Saída direto no buffer do binding quando a largura já é conhecida;
+        // no primeiro lote o ONNX Runtime aloca e a largura é descoberta
+        size_t width = outputWidth.load(memory_order_relaxed);
+        Ort::Value output{nullptr};
+        if (width != 0) {
+            size_t outputSize = static_cast<size_t>(batch.rows) * width;
+            if (binding->output.size() < outputSize) binding->output.resize(outputSize);
+            const int64_t outputShape[] = {batch.rows, static_cast<int64_t>(width)};
+            output = Ort::Value::CreateTensor<float>(memoryInfo, binding->output.data(), outputSize, outputShape, 2);
+            binding->binding.BindOutput(outputName.c_str(), output);
+        } else {
+            binding->binding.BindOutput(outputName.c_str(), memoryInfo);
+        }
+        
+        vector<vector<float>> rows;
+        try {
+            session.Run(Ort::RunOptions{}, binding->binding);
+            
+            if (width != 0) {
+                rows = splitRows(binding->output.data(), batch.rows, width);
+            } else {
+                vector<Ort::Value> values = binding->binding.GetOutputValues();
+                auto shape = values[0].GetTensorTypeAndShapeInfo().GetShape();
+                if (shape.empty() || shape[0] != batch.rows) {
+                    throw runtime_error("Saída do modelo não tem uma linha por pedido");
+                }
+                size_t rowSize = 1;
+                for (size_t d = 1; d < shape.size(); ++d) rowSize *= static_cast<size_t>(shape[d]);
+                rows = splitRows(values[0].GetTensorData<float>(), batch.rows, rowSize);
+                if (shape.size() == 2) outputWidth.store(rowSize, memory_order_relaxed);
+            }
+        } catch (...) {
+            binding->binding.ClearBoundInputs();
+            binding->binding.ClearBoundOutputs();
+            releaseBinding(move(binding));
+            throw;
+        }
+        
+        binding->binding.ClearBoundInputs();
+        binding->binding.ClearBoundOutputs();
+        releaseBinding(move(binding));
+        return rows;
+    }
+};
+
+// Motor para os modelos do diretório atual: "torch" usa model.pt, "onnx" usa
+// model.onnx e "auto" prefere o ONNX quando o arquivo existe
+shared_ptr<InferenceEngine> loadInferenceEngine(const string& preference, int intraOpThreads);
+
+// Agrupa pedidos de inferência em micro-lotes: o primeiro pedido da fila
+// espera até `maxWait` por outros, e o lote (até `maxBatch` pedidos) vira uma
+// única execução do motor com ids preenchidos até o maior texto e máscara de
+// atenção. Threads dedicadas (`workers`) rodam o motor com `intraOpThreads`
+// threads de operação e devolvem a linha de saída de cada pedido pelo seu
+// future.
+class InferenceScheduler {
+private:
+    struct Request {
+        vector<int64_t> ids;
+        promise<vector<float>> result;
+        chrono::steady_clock::time_point enqueued;
+    };
+    
+    shared_ptr<InferenceEngine> engine;
+    InferenceTunables tunables;
+    
+    deque<Request> queue;
+    mutable mutex mtx;
+    condition_variable cv;
+    bool stopping = false;
+    vector<thread> workers;
+    
+    atomic<uint64_t> requestCount{0};
+    atomic<uint64_t> batchCount{0};
+    atomic<uint64_t> rejectedCount{0};
+    atomic<uint64_t> batchedItems{0};
+    atomic<size_t> largestBatch{0};
+    atomic<uint64_t> queueMicrosTotal{0};
+    atomic<uint64_t> queueMicrosMax{0};
+    atomic<uint64_t> forwardMicrosTotal{0};
+    
+    static void updateMax(atomic<uint64_t>& target, uint64_t value) {
+        uint64_t current = target.load(memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, memory_order_relaxed)) {}
+    }
+    
+    void runBatch(vector<Request>& batch, InferenceBatch& packed) {
+        auto started = chrono::steady_clock::now();
+        for (const auto& request : batch) {
+            uint64_t waited = static_cast<uint64_t>(
+                chrono::duration_cast<chrono::microseconds>(started - request.enqueued).count());
+            queueMicrosTotal.fetch_add(waited, memory_order_relaxed);
+            updateMax(queueMicrosMax, waited);
+        }
+        
+        try {
+            size_t longest = 0;
+            for (const auto& request : batch) longest = max(longest, request.ids.size());
+            
+            packed.reset(batch.size(), longest);
+            for (size_t row = 0; row < batch.size(); ++row) packed.setRow(row, batch[row].ids);
+            
+            auto outputs = engine->run(packed);
+            if (outputs.size() != batch.size()) {
+                throw runtime_error("Saída do modelo não tem uma linha por pedido");
+            }
+            for (size_t row = 0; row < batch.size(); ++row) {
+                batch[row].result.set_value(move(outputs[row]));
+            }
+        } catch (...) {
+            for (auto& request : batch) request.result.set_exception(current_exception());
+        }
+        
+        forwardMicrosTotal.fetch_add(static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(
+                                         chrono::steady_clock::now() - started).count()),
+                                     memory_order_relaxed);
+        batchCount.fetch_add(1, memory_order_relaxed);
+        batchedItems.fetch_add(batch.size(), memory_order_relaxed);
+        size_t largest = largestBatch.load(memory_order_relaxed);
+        while (batch.size() > largest && !largestBatch.compare_exchange_weak(largest, batch.size())) {}
+    }
+    
+    void workerLoop() {
+        // Orçamento de threads de operação próprio, separado das threads HTTP
+        engine->prepareThread();
+        
+        InferenceBatch packed;
+        vector<Request> batch;
+        batch.reserve(tunables.maxBatch);
+        while (true) {
+            {
+                unique_lock<mutex> lock(mtx);
+                cv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping && queue.empty()) return;
+                
+                // Espera o lote encher ou o prazo do pedido mais antigo vencer
+                auto deadline = queue.front().enqueued + tunables.maxWait;
+                cv.wait_until(lock, deadline, [this] { return stopping || queue.size() >= tunables.maxBatch; });
+                
+                size_t take = min(queue.size(), tunables.maxBatch);
+                for (size_t i = 0; i < take; ++i) {
+                    batch.push_back(move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            
+            runBatch(batch, packed);
+            batch.clear();
+        }
+    }
+    
+public:
+    InferenceScheduler(shared_ptr<InferenceEngine> engine, InferenceTunables tunables = {})
+        : engine(move(engine)), tunables(tunables) {
+        this->tunables.maxBatch = max<size_t>(1, this->tunables.maxBatch);
+        this->tunables.vocabularySize = max<int64_t>(2, this->tunables.vocabularySize);
+        this->tunables.workers = max<size_t>(1, this->tunables.workers);
+        for (size_t i = 0; i < this->tunables.workers; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+    
+    ~InferenceScheduler() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+    
+    InferenceScheduler(const InferenceScheduler&) = delete;
+    InferenceScheduler& operator=(const InferenceScheduler&) = delete;
+    
+    // Enfileira o texto; o future recebe a linha de saída do modelo
+    future<vector<float>> submit(string_view text) {
+        Request request;
+        request.ids = InferenceBatch::encode(text, tunables.maxSequence, tunables.vocabularySize);
+        request.enqueued = chrono::steady_clock::now();
+        auto result = request.result.get_future();
+        
+        bool full = false;
+        {
+            lock_guard<mutex> lock(mtx);
+            if (queue.size() >= tunables.maxQueue) {
+                full = true;
+            } else {
+                queue.push_back(move(request));
+            }
+        }
+        if (full) {
+            rejectedCount.fetch_add(1, memory_order_relaxed);
+            request.result.set_exception(make_exception_ptr(runtime_error("Fila de inferência cheia")));
+            return result;
+        }
+        
+        requestCount.fetch_add(1, memory_order_relaxed);
+        cv.notify_one();
+        return result;
+    }
+    
+    string engineName() const {
+        return engine->name();
+    }
+    
+    // Executa lotes sintéticos do menor e do maior formato (1 e maxBatch
+    // pedidos de maxSequence tokens), para que a compilação JIT, os pools de
+    // threads e os alocadores já estejam quentes quando chegar tráfego real
+    void warmUp() {
+        engine->prepareThread();
+        
+        mt19937_64 random(42);
+        uniform_int_distribution<int64_t> tokenId(1, tunables.vocabularySize - 1);
+        vector<int64_t> sequence(tunables.maxSequence);
+        
+        InferenceBatch batch;
+        for (size_t rows : {size_t(1), tunables.maxBatch}) {
+            batch.reset(rows, tunables.maxSequence);
+            for (size_t row = 0; row < rows; ++row) {
+                for (auto& id : sequence) id = tokenId(random);
+                batch.setRow(row, sequence);
+            }
+            for (size_t run = 0; run < tunables.warmupRuns; ++run) engine->run(batch);
+        }
+    }
+    
+    const InferenceTunables& getTunables() const {
+        return tunables;
+    }
+    
+    InferenceMetrics metrics() const {
+        InferenceMetrics snapshot;
+        snapshot.requests = requestCount.load(memory_order_relaxed);
+        snapshot.batches = batchCount.load(memory_order_relaxed);
+        snapshot.rejected = rejectedCount.load(memory_order_relaxed);
+        snapshot.maxBatchSize = largestBatch.load(memory_order_relaxed);
+        snapshot.maxQueueMicros = queueMicrosMax.load(memory_order_relaxed);
+        
+        uint64_t items = batchedItems.load(memory_order_relaxed);
+        if (snapshot.batches > 0) {
+            snapshot.meanBatchSize = static_cast<double>(items) / snapshot.batches;
+            snapshot.meanForwardMicros = static_cast<double>(forwardMicrosTotal.load(memory_order_relaxed)) / snapshot.batches;
+        }
+        if (items > 0) {
+            snapshot.meanQueueMicros = static_cast<double>(queueMicrosTotal.load(memory_order_relaxed)) / items;
+        }
+        {
+            lock_guard<mutex> lock(mtx);
+            snapshot.queueDepth = queue.size();
+        }
+        return snapshot;
+    }
+};
@@ -0,0 +1,271 @@
+// job_queue.h - Fila assíncrona de geração de documentos
+#pragma once
+
+#include "common.h"
+
+// Limites da fila: jobs aguardando, tempo que um job terminado fica
+// disponível e bytes somados dos jobs terminados guardados
+struct JobQueueBudget {
+    size_t maxPending = 64;
+    chrono::seconds ttl = chrono::minutes(10);
+    size_t maxRetainedBytes = 256 * 1024 * 1024;
+};
+
+// Fila assíncrona de geração de documentos. Um número limitado de slots de
+// geração é dividido entre os workers da fila e as rotas que geram direto na
+// requisição, para que exportações grandes não tomem as threads do servidor
+// HTTP. Jobs terminados ficam disponíveis para download até o TTL expirar ou
+// até os jobs terminados depois deles passarem do limite de bytes, o que
+// vier primeiro; os mais antigos saem primeiro.
+class JobQueue {
+public:
+    enum class JobStatus { Queued, Running, Done, Failed };
+    
+    struct Artifact {
+        shared_ptr<const string> content;
+        string filename;
+        string contentType;
+        string etag;
+    };
+    
+    struct JobSnapshot {
+        string id;
+        JobStatus status = JobStatus::Queued;
+        string error;
+        Artifact artifact;
+    };
+    
+    // Gera o artefato; lança exceção em caso de erro
+    using Task = function<Artifact()>;
+    
+    // Slot de geração mantido enquanto o objeto existir
+    class Slot {
+    private:
+        JobQueue* queue;
+        
+    public:
+        explicit Slot(JobQueue* queue) : queue(queue) {}
+        ~Slot() { queue->releaseSlot(); }
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+    };
+    
+    static const char* statusName(JobStatus status) {
+        switch (status) {
+            case JobStatus::Queued: return "queued";
+            case JobStatus::Running: return "running";
+            case JobStatus::Done: return "done";
+            case JobStatus::Failed: return "failed";
+        }
+        return "unknown";
+    }
+    
+private:
+    struct Job {
+        JobSnapshot state;
+        Task task;
+        chrono::steady_clock::time_point finishedAt;
+        size_t retained = 0;
+    };
+    
+    // Custo mínimo de um job terminado, para que jobs sem artefato (falhas)
+    // também contem no limite
+    static constexpr size_t JOB_OVERHEAD = 1024;
+    
+    const size_t capacity;
+    const chrono::seconds ttl;
+    const size_t maxRetainedBytes;
+    
+    mutex mtx;
+    condition_variable queueCv;     // novos jobs / parada
+    condition_variable finishedCv;  // jobs terminados (long-poll)
+    condition_variable slotCv;      // slots liberados
+    condition_variable janitorCv;   // parada da limpeza
+    unordered_map<string, shared_ptr<Job>> jobs;
+    deque<shared_ptr<Job>> pending;
+    deque<shared_ptr<Job>> finished;  // em ordem de término
+    size_t retainedBytes = 0;
+    size_t freeSlots;
+    bool stopping = false;
+    mt19937_64 idGenerator{random_device{}()};
+    vector<thread> workers;
+    thread janitor;
+    
+    string newJobId() {
+        // Chamado com `mtx` travado
+        static const char* hex_chars = "0123456789abcdef";
+        string id;
+        for (int part = 0; part < 2; ++part) {
+            uint64_t bits = idGenerator();
+            for (int i = 0; i < 16; ++i) {
+                id += hex_chars[bits & 0xf];
+                bits >>= 4;
+            }
+        }
+        return id;
+    }
+    
+    void releaseSlot() {
+        {
+            lock_guard<mutex> lock(mtx);
+            ++freeSlots;
+        }
+        slotCv.notify_one();
+    }
+    
+    void workerLoop() {
+        while (true) {
+            shared_ptr<Job> job;
+            {
+                unique_lock<mutex> lock(mtx);
+                queueCv.wait(lock, [this] { return stopping || !pending.empty(); });
+                if (stopping) return;
+                
+                // Divide os slots com as gerações feitas direto nas rotas
+                slotCv.wait(lock, [this] { return stopping || freeSlots > 0; });
+                if (stopping) return;
+                if (pending.empty()) continue;
+                
+                --freeSlots;
+                job = move(pending.front());
+                pending.pop_front();
+                job->state.status = JobStatus::Running;
+            }
+            
+            Slot slot(this);
+            Artifact artifact;
+            string error;
+            try {
+                artifact = job->task();
+            } catch (const exception& e) {
+                error = e.what();
+            }
+            
+            size_t artifactBytes = artifact.content ? artifact.content->size() : 0;
+            if (error.empty() && artifactBytes + JOB_OVERHEAD > maxRetainedBytes) {
+                error = "Documento gerado maior que o limite de jobs guardados";
+                artifact = {};
+            }
+            
+            {
+                lock_guard<mutex> lock(mtx);
+                job->task = nullptr;
+                job->finishedAt = chrono::steady_clock::now();
+                if (error.empty()) {
+                    job->state.status = JobStatus::Done;
+                    job->state.artifact = move(artifact);
+                    job->retained = artifactBytes + JOB_OVERHEAD;
+                } else {
+                    job->state.status = JobStatus::Failed;
+                    job->state.error = move(error);
+                    job->retained = JOB_OVERHEAD + job->state.error.size();
+                }
+                retainedBytes += job->retained;
+                finished.push_back(job);
+                while (retainedBytes > maxRetainedBytes && finished.front() != job) dropOldestFinished();
+            }
+            finishedCv.notify_all();
+        }
+    }
+    
+    // Chamado com `mtx` travado
+    void dropOldestFinished() {
+        retainedBytes -= finished.front()->retained;
+        jobs.erase(finished.front()->state.id);
+        finished.pop_front();
+    }
+    
+    // Remove periodicamente os jobs terminados cujo TTL expirou; como o TTL
+    // é o mesmo para todos, eles expiram na ordem de término
+    void janitorLoop() {
+        const auto interval = max(chrono::seconds(1), ttl / 4);
+        unique_lock<mutex> lock(mtx);
+        while (!stopping) {
+            janitorCv.wait_for(lock, interval, [this] { return stopping; });
+            if (stopping) return;
+            
+            auto now = chrono::steady_clock::now();
+            while (!finished.empty() && now - finished.front()->finishedAt > ttl) dropOldestFinished();
+        }
+    }
+    
+public:
+    JobQueue(size_t concurrency, const JobQueueBudget& budget = {})
+        : capacity(budget.maxPending), ttl(budget.ttl), maxRetainedBytes(budget.maxRetainedBytes),
+          freeSlots(max<size_t>(concurrency, 1)) {
+        for (size_t i = 0; i < freeSlots; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+        janitor = thread([this] { janitorLoop(); });
+    }
+    
+    ~JobQueue() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        queueCv.notify_all();
+        slotCv.notify_all();
+        finishedCv.notify_all();
+        janitorCv.notify_all();
+        for (auto& worker : workers) worker.join();
+        janitor.join();
+    }
+    
+    JobQueue(const JobQueue&) = delete;
+    JobQueue& operator=(const JobQueue&) = delete;
+    
+    // Enfileira um job; retorna nullopt se a fila estiver cheia
+    optional<string> submit(Task task) {
+        string id;
+        {
+            lock_guard<mutex> lock(mtx);
+            if (stopping || pending.size() >= capacity) return nullopt;
+            
+            id = newJobId();
+            auto job = make_shared<Job>();
+            job->state.id = id;
+            job->task = move(task);
+            jobs.emplace(id, job);
+            pending.push_back(move(job));
+        }
+        queueCv.notify_one();
+        return id;
+    }
+    
+    // Estado do job; com `wait` > 0, espera até ele terminar ou o prazo acabar
+    optional<JobSnapshot> status(const string& id, chrono::milliseconds wait = chrono::milliseconds(0)) {
+        unique_lock<mutex> lock(mtx);
+        auto it = jobs.find(id);
+        if (it == jobs.end()) return nullopt;
+        
+        shared_ptr<Job> job = it->second;
+        if (wait.count() > 0) {
+            finishedCv.wait_for(lock, wait, [&] {
+                return stopping || job->state.status == JobStatus::Done ||
+                       job->state.status == JobStatus::Failed;
+            });
+        }
+        return job->state;
+    }
+    
+    // Slot para gerar um documento direto na requisição; nullptr se todos
+    // estiverem ocupados
+    unique_ptr<Slot> tryAcquireSlot() {
+        lock_guard<mutex> lock(mtx);
+        if (freeSlots == 0) return nullptr;
+        --freeSlots;
+        return make_unique<Slot>(this);
+    }
+    
+    size_t queueDepth() {
+        lock_guard<mutex> lock(mtx);
+        return pending.size();
+    }
+    
+    // Bytes dos jobs terminados ainda guardados para download
+    size_t retainedByteCount() {
+        lock_guard<mutex> lock(mtx);
+        return retainedBytes;
+    }
+};
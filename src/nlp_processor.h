@@ -0,0 +1,320 @@
+// nlp_processor.h - Processador de linguagem natural
+#pragma once
+
+#include "common.h"
+#include "telemetry.h"
+#include "text.h"
+#include "cache.h"
+#include "inference.h"
+#include "worker_pool.h"
+
+// Duração de cada etapa da inicialização do NLP, em milissegundos
+struct StartupTimings {
+    double cacheOpen = 0.0;
+    double dictionaries = 0.0;
+    double modelLoad = 0.0;
+    double warmup = 0.0;
+    double total = 0.0;
+};
+
+class NLPProcessor {
+private:
+    // Publicados pela thread de inicialização; nulos até lá (ou se falharem)
+    shared_ptr<InferenceScheduler> inference;
+    shared_ptr<NLPCacheStore> cacheStore;
+    ShardedLruCache memoryCache{10000, 64 * 1024 * 1024};
+    SingleFlight<string> processFlight;
+    shared_ptr<const SentimentLexicon> lexicon = make_shared<SentimentLexicon>();
+    shared_ptr<const EntityExtractor> entityExtractor = make_shared<EntityExtractor>();
+    
+    atomic<bool> ready{false};
+    atomic<const char*> stage{"iniciando"};
+    StartupTimings timings;  // escrito só pela thread de inicialização, lido depois de `ready`
+    thread initializer;
+    
+    // Textos a partir deste tamanho têm sentimento e entidades calculados em
+    // paralelo, em segmentos de cerca de PARALLEL_SEGMENT_BYTES cortados em
+    // fins de frase
+    static constexpr size_t PARALLEL_ANALYSIS_BYTES = 256 * 1024;
+    static constexpr size_t PARALLEL_SEGMENT_BYTES = 64 * 1024;
+    
+    static vector<pair<size_t, size_t>> analysisSegments(string_view text) {
+        if (text.size() < PARALLEL_ANALYSIS_BYTES || WorkerPool::shared().size() < 2) {
+            return {{0, text.size()}};
+        }
+        return splitAtSentences(text, PARALLEL_SEGMENT_BYTES);
+    }
+    
+    // Abre o cache, carrega dicionários e modelo e aquece o modelo, nessa
+    // ordem; cada etapa que termina já passa a ser usada pelas requisições
+    void initialize(InferenceTunables tunables, string engine, NLPCacheBudget cacheBudget) {
+        auto started = chrono::steady_clock::now();
+        auto lap = [last = started]() mutable {
+            auto now = chrono::steady_clock::now();
+            double elapsed = chrono::duration<double, milli>(now - last).count();
+            last = now;
+            return elapsed;
+        };
+        
+        stage = "cache";
+        atomic_store(&cacheStore, make_shared<NLPCacheStore>("nlp_cache.db", cacheBudget));
+        timings.cacheOpen = lap();
+        
+        stage = "dicionarios";
+        // Léxico de sentimentos opcional; sem ele ficam só os termos padrão
+        if (ifstream("sentiment_lexicon.tsv")) {
+            loadLexicon("sentiment_lexicon.tsv");
+        }
+        // Dicionário opcional de nomes conhecidos para o extrator de entidades
+        if (ifstream("entity_gazetteer.tsv")) {
+            loadGazetteer("entity_gazetteer.tsv");
+        }
+        timings.dictionaries = lap();
+        
+        // Modelo de NLP; sem ele as respostas não têm classificação
+        try {
+            stage = "modelo";
+            auto scheduler = make_shared<InferenceScheduler>(loadInferenceEngine(engine, tunables.intraOpThreads), tunables);
+            timings.modelLoad = lap();
+            
+            stage = "aquecimento";
+            scheduler->warmUp();
+            timings.warmup = lap();
+            atomic_store(&inference, move(scheduler));
+        } catch (const exception& e) {
+            cerr << theme.error << "Erro ao carregar modelo NLP: " << e.what() << COLOR_RESET << endl;
+        }
+        
+        timings.total = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        cout << theme.success << "NLP pronto em " << timings.total << " ms (cache " << timings.cacheOpen
+             << " ms, dicionários " << timings.dictionaries << " ms, modelo " << timings.modelLoad
+             << " ms, aquecimento " << timings.warmup << " ms)" << COLOR_RESET << endl;
+        stage = "pronto";
+        ready = true;
+    }
+    
+public:
+    // `engine` escolhe o motor de inferência: "torch", "onnx" ou "auto". A
+    // inicialização pesada roda em segundo plano; até terminar, o
+    // processamento segue sem o cache persistente e sem o modelo.
+    // `cacheBudget` limita o tamanho e a idade das entradas do cache SQLite.
+    explicit NLPProcessor(InferenceTunables tunables = {}, const string& engine = "auto",
+                          NLPCacheBudget cacheBudget = {}) {
+        initializer = thread([this, tunables, engine, cacheBudget] { initialize(tunables, engine, cacheBudget); });
+    }
+    
+    ~NLPProcessor() {
+        if (initializer.joinable()) initializer.join();
+    }
+    
+    NLPProcessor(const NLPProcessor&) = delete;
+    NLPProcessor& operator=(const NLPProcessor&) = delete;
+    
+    bool isReady() const {
+        return ready;
+    }
+    
+    // Etapa atual da inicialização, para o /readyz
+    const char* startupStage() const {
+        return stage;
+    }
+    
+    optional<StartupTimings> startupTimings() const {
+        if (!ready) return nullopt;
+        return timings;
+    }
+    
+    // Troca o léxico por um carregado de arquivo (somado aos termos padrão).
+    // Pode ser chamado com o servidor rodando: requisições em andamento
+    // terminam com o léxico anterior.
+    bool loadLexicon(const string& path) {
+        try {
+            auto loaded = make_shared<SentimentLexicon>();
+            loaded->loadFile(path);
+            atomic_store(&lexicon, shared_ptr<const SentimentLexicon>(move(loaded)));
+            cout << theme.success << "Léxico de sentimentos carregado: " << path << COLOR_RESET << endl;
+            return true;
+        } catch (const exception& e) {
+            cerr << theme.error << "Erro ao carregar léxico: " << e.what() << COLOR_RESET << endl;
+            return false;
+        }
+    }
+    
+    // Recompila o extrator de entidades com o dicionário de `path`
+    bool loadGazetteer(const string& path) {
+        try {
+            auto loaded = make_shared<EntityExtractor>();
+            loaded->loadGazetteer(path);
+            loaded->build();
+            atomic_store(&entityExtractor, shared_ptr<const EntityExtractor>(move(loaded)));
+            cout << theme.success << "Dicionário de entidades carregado: " << path << COLOR_RESET << endl;
+            return true;
+        } catch (const exception& e) {
+            cerr << theme.error << "Erro ao carregar dicionário de entidades: " << e.what() << COLOR_RESET << endl;
+            return false;
+        }
+    }
+    
+    // Os tokens apontam para dentro de `text`, que precisa continuar vivo. O
+    // vetor é alocado em `memory` (a arena da requisição, se houver).
+    pmr::vector<string_view> tokenize(string_view text, pmr::memory_resource* memory = pmr::get_default_resource()) {
+        static auto& tokenizeStage = stageHistogram("tokenize");
+        StageTimer timer(tokenizeStage, "tokenize");
+        return Utf8Tokenizer::tokenize(text, memory);
+    }
+    
+    // `memory` só é usada no caminho sequencial: os segmentos de textos
+    // grandes rodam em outras threads e alocam no heap
+    double analyzeSentiment(string_view text, pmr::memory_resource* memory = pmr::get_default_resource()) {
+        static auto& sentimentStage = stageHistogram("sentiment");
+        StageTimer timer(sentimentStage, "sentiment");
+        auto currentLexicon = atomic_load(&lexicon);
+        
+        // Negações e intensificadores não passam de uma frase para outra, então
+        // a soma por segmentos de frases inteiras é a mesma do texto todo
+        auto segments = analysisSegments(text);
+        if (segments.size() < 2) {
+            auto tokens = tokenize(text, memory);
+            return tanh(currentLexicon->rawScore(tokens)); // Normalizar entre -1 e 1
+        }
+        
+        vector<double> partial(segments.size());
+        WorkerPool::shared().parallelFor(segments.size(), [&](size_t i) {
+            TraceSpan span("sentiment_segment");
+            string_view segment = text.substr(segments[i].first, segments[i].second - segments[i].first);
+            partial[i] = currentLexicon->rawScore(Utf8Tokenizer::tokenize(segment));
+        });
+        return tanh(accumulate(partial.begin(), partial.end(), 0.0));
+    }
+    
+    // Entidades como intervalos de `text`, sem copiar o texto delas; o vetor
+    // é alocado em `memory`
+    EntityMatches findEntities(string_view text, pmr::memory_resource* memory = pmr::get_default_resource()) {
+        static auto& entitiesStage = stageHistogram("entities");
+        StageTimer timer(entitiesStage, "entities");
+        auto currentExtractor = atomic_load(&entityExtractor);
+        
+        auto segments = analysisSegments(text);
+        if (segments.size() < 2) {
+            return currentExtractor->scan(text, memory);
+        }
+        
+        vector<EntityMatches> parts(segments.size());
+        WorkerPool::shared().parallelFor(segments.size(), [&](size_t i) {
+            TraceSpan span("entities_segment");
+            parts[i] = currentExtractor->scanRange(text, segments[i].first, segments[i].second);
+        });
+        return EntityExtractor::merge(move(parts), memory);
+    }
+    
+    vector<pair<string, string>> extractNamedEntities(string_view text) {
+        return EntityExtractor::toPairs(text, findEntities(text));
+    }
+    
+    string processText(const string& text) {
+        static auto& cacheStage = stageHistogram("cache_lookup");
+        static auto& inferenceStage = stageHistogram("inference");
+        static auto& memoryHits = Telemetry::get().counter(
+            "paulo_nlp_cache_requests_total", "Consultas ao cache de processamento de texto", "result=\"memory_hit\"");
+        static auto& diskHits = Telemetry::get().counter(
+            "paulo_nlp_cache_requests_total", "Consultas ao cache de processamento de texto", "result=\"disk_hit\"");
+        static auto& misses = Telemetry::get().counter(
+            "paulo_nlp_cache_requests_total", "Consultas ao cache de processamento de texto", "result=\"miss\"");
+        
+        // Verificar cache: primeiro a memória, depois o SQLite
+        optional<string> cached;
+        {
+            StageTimer timer(cacheStage, "cache_memory");
+            cached = memoryCache.get(text);
+        }
+        if (cached) {
+            memoryHits.add();
+            return *cached;
+        }
+        
+        // Textos idênticos simultâneos esperam pelo primeiro
+        return processFlight.run(text, [&] {
+            auto store = atomic_load(&cacheStore);
+            if (store) {
+                optional<string> stored;
+                {
+                    StageTimer timer(cacheStage, "cache_sqlite");
+                    stored = store->lookup(text);
+                }
+                if (stored) {
+                    diskHits.add();
+                    memoryCache.put(text, *stored);
+                    return *stored;
+                }
+            }
+            misses.add();
+            
+            string result = "Resposta processada: " + text;
+            
+            // Classificação do modelo, feita em lote com outros pedidos
+            auto scheduler = atomic_load(&inference);
+            if (scheduler) {
+                try {
+                    StageTimer timer(inferenceStage, "inference");
+                    result += describeModelOutput(scheduler->submit(text).get());
+                } catch (const exception& e) {
+                    // Falha transitória (fila cheia, erro no modelo): responde
+                    // sem a classificação e não guarda no cache
+                    cerr << theme.error << "Erro na inferência: " << e.what() << COLOR_RESET << endl;
+                    return result;
+                }
+            } else if (!ready) {
+                // Modelo ainda carregando: a resposta não vai para o cache
+                return result;
+            }
+            
+            // Armazenar no cache
+            memoryCache.put(text, result);
+            if (store) store->store(text, result);
+            
+            return result;
+        });
+    }
+    
+    uint64_t coalescedRequests() const {
+        return processFlight.coalescedCount();
+    }
+    
+    // Métricas do agendador de inferência; vazio se o modelo não carregou
+    optional<InferenceMetrics> inferenceMetrics() const {
+        auto scheduler = atomic_load(&inference);
+        if (!scheduler) return nullopt;
+        return scheduler->metrics();
+    }
+    
+    optional<string> inferenceEngine() const {
+        auto scheduler = atomic_load(&inference);
+        if (!scheduler) return nullopt;
+        return scheduler->engineName();
+    }
+    
+    optional<InferenceTunables> inferenceTunables() const {
+        auto scheduler = atomic_load(&inference);
+        if (!scheduler) return nullopt;
+        return scheduler->getTunables();
+    }
+    
+private:
+    // Uma saída escalar vira escore; um vetor, a classe mais provável
+    static string describeModelOutput(const vector<float>& scores) {
+        if (scores.empty()) return "";
+        
+        ostringstream out;
+        out.precision(3);
+        if (scores.size() == 1) {
+            out << "\nEscore do modelo: " << scores[0];
+            return out.str();
+        }
+        
+        size_t best = static_cast<size_t>(max_element(scores.begin(), scores.end()) - scores.begin());
+        double total = 0.0;
+        for (float score : scores) total += exp(static_cast<double>(score - scores[best]));
+        out << "\nClassificação do modelo: classe " << best << " (confiança " << 100.0 / total << "%)";
+        return out.str();
+    }
+};
@@ -0,0 +1,1253 @@
+// paulo_roberto_ai.h - Servidor HTTP do Paulo Roberto AI
+#pragma once
+
+#include "common.h"
+#include "telemetry.h"
+#include "text.h"
+#include "nlp_processor.h"
+#include "documents.h"
+#include "artifact_cache.h"
+#include "job_queue.h"
+#include "arena.h"
+#include "server_config.h"
+#include "index_page.h"
+#include <httplib.h>
+#include <sys/socket.h>
+#include <openssl/crypto.h>  // CRYPTO_memcmp
+
+using namespace httplib;
+
+// Lê um item do /api/process_batch (uma linha NDJSON) sem montar o DOM: só
+// guarda "input" e "id" do objeto de nível mais alto e ignora o resto
+class BatchItemReader : public nlohmann::json_sax<json> {
+private:
+    // Os nomes dos métodos do SAX escondem `string` dentro da classe
+    size_t depth = 0;
+    std::string currentKey;
+    
+    bool atTopLevel() const {
+        return depth == 1;
+    }
+    
+    bool notAnObject() {
+        error = "Cada linha deve ser um objeto JSON";
+        return false;
+    }
+    
+    bool scalar(json value) {
+        if (depth == 0) return notAnObject();
+        if (atTopLevel() && currentKey == "id") id = move(value);
+        return true;
+    }
+    
+public:
+    optional<std::string> input;
+    json id;  // devolvido como veio; nulo se ausente
+    std::string error;
+    
+    static BatchItemReader parse(string_view line) {
+        BatchItemReader reader;
+        bool ok = json::sax_parse(line.begin(), line.end(), &reader);
+        if (ok && !reader.input) reader.error = "Campo \"input\" ausente";
+        return reader;
+    }
+    
+    bool null() override { return scalar(nullptr); }
+    bool boolean(bool value) override { return scalar(value); }
+    bool number_integer(number_integer_t value) override { return scalar(value); }
+    bool number_unsigned(number_unsigned_t value) override { return scalar(value); }
+    bool number_float(number_float_t value, const string_t&) override { return scalar(value); }
+    bool binary(binary_t&) override { return true; }
+    
+    bool string(string_t& value) override {
+        if (atTopLevel() && currentKey == "input") {
+            input = move(value);
+            return true;
+        }
+        return scalar(value);
+    }
+    
+    bool key(string_t& value) override {
+        if (atTopLevel()) currentKey = move(value);
+        return true;
+    }
+    
+    bool start_object(size_t) override {
+        ++depth;
+        return true;
+    }
+    
+    bool end_object() override {
+        --depth;
+        return true;
+    }
+    
+    bool start_array(size_t) override {
+        if (depth == 0) return notAnObject();
+        ++depth;
+        return true;
+    }
+    
+    bool end_array() override {
+        --depth;
+        return true;
+    }
+    
+    bool parse_error(size_t, const std::string&, const nlohmann::detail::exception& e) override {
+        error = e.what();
+        return false;
+    }
+};
+
+class PauloRobertoAI {
+private:
+    ServerConfig config;
+    NLPProcessor nlp{config.inference, config.engine, config.nlpCache};
+    IntentRouter router;
+    FileGenerator fileGen;
+    ArtifactCache artifacts{config.artifactCache};
+    JobQueue jobs{max(2u, thread::hardware_concurrency() / 2), config.jobs};
+    vector<unique_ptr<Server>> servers;  // um por listener
+    
+    static constexpr const char* PPTX_CONTENT_TYPE = "application/vnd.openxmlformats-officedocument.presentationml.presentation";
+    static constexpr const char* XLSX_CONTENT_TYPE = "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet";
+    
+    // Limites do /api/process_batch
+    static constexpr size_t MAX_BATCH_ITEMS = 10000;
+    static constexpr size_t MAX_BATCH_LINE = 1024 * 1024;
+    
+    // Planilhas de jobs ficam inteiras em memória até o download; acima
+    // disso só o /api/generate_xlsx, que transmite sem bufferizar
+    static constexpr size_t MAX_BUFFERED_XLSX_ROWS = 100000;
+    static constexpr size_t MAX_BUFFERED_XLSX_BYTES = 32 * 1024 * 1024;
+    
+    // Recusa antes de gerar o que certamente passaria do limite: o XML tem
+    // pelo menos o tamanho dos textos das células
+    static void checkBufferedXLSX(const vector<vector<string>>& data) {
+        if (data.size() > MAX_BUFFERED_XLSX_ROWS) {
+            throw length_error("Planilha com mais de " + to_string(MAX_BUFFERED_XLSX_ROWS) + " linhas");
+        }
+        size_t bytes = 0;
+        for (const auto& row : data) {
+            for (const auto& cell : row) bytes += cell.size();
+        }
+        if (bytes > MAX_BUFFERED_XLSX_BYTES) {
+            throw length_error("Planilha com mais de " + to_string(MAX_BUFFERED_XLSX_BYTES) + " bytes de dados");
+        }
+    }
+    
+    // Documento do cache ou, se não houver, gerado agora e guardado
+    shared_ptr<const string> cachedPPTX(const string& key, const vector<string>& slides) {
+        if (auto content = artifacts.get(key)) return content;
+        
+        auto content = make_shared<string>();
+        if (!fileGen.generatePPTX(slides, *content)) {
+            throw runtime_error("Erro ao gerar apresentação");
+        }
+        artifacts.put(key, content);
+        return content;
+    }
+    
+    shared_ptr<const string> cachedXLSX(const string& key, const vector<vector<string>>& data) {
+        if (auto content = artifacts.get(key)) return content;
+        
+        checkBufferedXLSX(data);
+        auto content = make_shared<string>();
+        bool tooLarge = false;
+        bool ok = fileGen.generateXLSX(data, [&](const char* bytes, size_t size) {
+            tooLarge = content->size() + size > MAX_BUFFERED_XLSX_BYTES;
+            if (!tooLarge) content->append(bytes, size);
+            return !tooLarge;
+        });
+        if (tooLarge) {
+            throw length_error("Planilha gerada passa de " + to_string(MAX_BUFFERED_XLSX_BYTES) + " bytes");
+        }
+        if (!ok) {
+            throw runtime_error("Erro ao gerar planilha");
+        }
+        artifacts.put(key, content);
+        return content;
+    }
+    
+    optional<string> submitPPTXJob(vector<string> slides) {
+        return jobs.submit([this, slides = move(slides), trace = Tracer::currentTrace()]() {
+            TraceContext traceContext(trace);
+            TraceSpan span("job_pptx");
+            string key = ArtifactCache::keyFor(slides);
+            return JobQueue::Artifact{cachedPPTX(key, slides), fileGen.generateFilename("apresentacao", ".pptx"),
+                                      PPTX_CONTENT_TYPE, ArtifactCache::etagFor(key)};
+        });
+    }
+    
+    optional<string> submitXLSXJob(vector<vector<string>> data) {
+        return jobs.submit([this, data = move(data), trace = Tracer::currentTrace()]() {
+            TraceContext traceContext(trace);
+            TraceSpan span("job_xlsx");
+            string key = ArtifactCache::keyFor(data);
+            return JobQueue::Artifact{cachedXLSX(key, data), fileGen.generateFilename("planilha", ".xlsx"),
+                                      XLSX_CONTENT_TYPE, ArtifactCache::etagFor(key)};
+        });
+    }
+    
+    // Compara o token em tempo constante, para não vazar o prefixo correto
+    bool isAdmin(const Request& req) const {
+        static constexpr string_view BEARER = "Bearer ";
+        string header = req.get_header_value("Authorization");
+        if (header.compare(0, BEARER.size(), BEARER) != 0) return false;
+        string_view token = string_view(header).substr(BEARER.size());
+        return token.size() == config.adminToken.size() &&
+               CRYPTO_memcmp(token.data(), config.adminToken.data(), token.size()) == 0;
+    }
+    
+    // Se o Accept-Encoding aceita gzip: "gzip" (ou "*", se gzip não aparecer
+    // explicitamente) com q maior que zero
+    static bool acceptsGzip(const string& acceptEncoding) {
+        auto trim = [](const string& text) {
+            size_t first = text.find_first_not_of(" \t");
+            if (first == string::npos) return string();
+            return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+        };
+        
+        optional<bool> gzip;
+        optional<bool> wildcard;
+        stringstream ss(acceptEncoding);
+        string item;
+        while (getline(ss, item, ',')) {
+            size_t semicolon = item.find(';');
+            string coding = trim(item.substr(0, semicolon));
+            transform(coding.begin(), coding.end(), coding.begin(),
+                      [](unsigned char c) { return static_cast<char>(tolower(c)); });
+            
+            double quality = 1.0;
+            if (semicolon != string::npos) {
+                string parameter = trim(item.substr(semicolon + 1));
+                if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+                    quality = strtod(parameter.c_str() + 2, nullptr);
+                }
+            }
+            
+            if (coding == "gzip" || coding == "x-gzip") {
+                gzip = quality > 0;
+            } else if (coding == "*") {
+                wildcard = quality > 0;
+            }
+        }
+        return gzip.value_or(wildcard.value_or(false));
+    }
+    
+    // Define o ETag e responde 304 se o cliente já tiver essa versão
+    static bool notModified(const Request& req, Response& res, const string& etag) {
+        res.set_header("ETag", etag);
+        string ifNoneMatch = req.get_header_value("If-None-Match");
+        if (ifNoneMatch.empty()) return false;
+        if (ifNoneMatch != "*" && ifNoneMatch.find(etag) == string::npos) return false;
+        
+        res.status = 304;
+        return true;
+    }
+    
+    // Limite de requisições simultâneas numa rota (ServerConfig::routeLimits)
+    class ConcurrencyLimit {
+    private:
+        const size_t limit;
+        atomic<size_t> active{0};
+        
+    public:
+        explicit ConcurrencyLimit(size_t limit) : limit(limit) {}
+        
+        bool tryEnter() {
+            size_t current = active.load(memory_order_relaxed);
+            while (current < limit) {
+                if (active.compare_exchange_weak(current, current + 1, memory_order_acquire)) return true;
+            }
+            return false;
+        }
+        
+        void leave() {
+            active.fetch_sub(1, memory_order_release);
+        }
+        
+        // Vaga ocupada enquanto o objeto existir; sem limite, sempre entra
+        class Slot {
+        private:
+            ConcurrencyLimit* owner;
+            
+        public:
+            explicit Slot(ConcurrencyLimit* limit) : owner(limit && limit->tryEnter() ? limit : nullptr),
+                                                     admitted(!limit || owner) {}
+            ~Slot() {
+                if (owner) owner->leave();
+            }
+            Slot(const Slot&) = delete;
+            Slot& operator=(const Slot&) = delete;
+            
+            const bool admitted;
+        };
+    };
+    
+    map<string, unique_ptr<ConcurrencyLimit>> routeLimits;
+    
+    // Long-polls de /api/jobs/<id>?wait= seguram uma thread do httplib
+    // enquanto esperam; no máximo um quarto das threads de cada listener
+    // fica nisso, e o resto responde na hora
+    static constexpr long MAX_JOB_WAIT_SECONDS = 10;
+    ConcurrencyLimit jobWaiters{max<size_t>(1, config.threads / config.listeners / 4)};
+    
+    // Latência e vaga de concorrência de uma requisição, fechadas quando a
+    // última referência sai de cena. O timed() cria uma por requisição; rotas
+    // cujo trabalho roda no content provider guardam RequestScope::current()
+    // no provider, e então as duas valem até o fim do envio do corpo.
+    class RequestScope {
+    private:
+        LatencyHistogram& latency;
+        const chrono::steady_clock::time_point started = chrono::steady_clock::now();
+        ConcurrencyLimit::Slot slot;
+        
+        static shared_ptr<RequestScope>& active() {
+            static thread_local shared_ptr<RequestScope> scope;
+            return scope;
+        }
+        
+    public:
+        RequestScope(LatencyHistogram& latency, ConcurrencyLimit* limit) : latency(latency), slot(limit) {}
+        
+        ~RequestScope() {
+            if (slot.admitted) latency.record(chrono::steady_clock::now() - started);
+        }
+        
+        RequestScope(const RequestScope&) = delete;
+        RequestScope& operator=(const RequestScope&) = delete;
+        
+        bool admitted() const {
+            return slot.admitted;
+        }
+        
+        // Escopo da requisição em andamento nesta thread (só dentro do handler)
+        static shared_ptr<RequestScope> current() {
+            return active();
+        }
+        
+        // Torna `scope` o atual enquanto o objeto existir
+        class Activation {
+        public:
+            explicit Activation(shared_ptr<RequestScope> scope) {
+                active() = move(scope);
+            }
+            ~Activation() {
+                active().reset();
+            }
+            Activation(const Activation&) = delete;
+            Activation& operator=(const Activation&) = delete;
+        };
+    };
+    
+    // Envolve o handler de uma rota para medir a latência, contar as
+    // respostas por classe de status e abrir o trace da requisição (quando
+    // amostrada). A latência vai até o handler retornar ou, se ele guardar o
+    // RequestScope no content provider, até o fim do envio do corpo.
+    // `Route` é Server::HandlerWithContentReader para rotas que leem o corpo
+    // aos poucos.
+    //
+    // Se a rota tiver limite de concorrência e ele estiver esgotado, responde
+    // 503 sem chamar o handler. A vaga dura o mesmo que a latência.
+    template<typename Route = Server::Handler, typename F>
+    Route timed(const string& method, const string& route, F handler) {
+        auto& telemetry = Telemetry::get();
+        string labels = "method=\"" + method + "\",route=\"" + route + "\"";
+        auto& latency = telemetry.histogram("paulo_http_request_duration_seconds", "Latência das rotas HTTP", labels);
+        array<TelemetryCounter*, 5> responses;
+        for (size_t i = 0; i < responses.size(); ++i) {
+            responses[i] = &telemetry.counter("paulo_http_responses_total", "Respostas HTTP por classe de status",
+                                              labels + ",code=\"" + to_string(i + 1) + "xx\"");
+        }
+        
+        const auto& known = ServerConfig::knownRoutes();
+        if (find(known.begin(), known.end(), route) == known.end()) {
+            throw logic_error("Rota fora de ServerConfig::knownRoutes(): " + route);
+        }
+        
+        const char* spanName = Tracer::get().intern(method + " " + route);
+        
+        auto found = routeLimits.find(route);
+        ConcurrencyLimit* limit = found == routeLimits.end() ? nullptr : found->second.get();
+        TelemetryCounter* rejected = limit ? &telemetry.counter("paulo_http_rejected_total",
+                                                                "Requisições recusadas pelo limite de concorrência da rota",
+                                                                "route=\"" + route + "\"") : nullptr;
+        
+        return [&latency, responses, spanName, limit, rejected, handler = move(handler)](const Request& req, Response& res,
+                                                                                         const auto&... reader) {
+            auto scope = make_shared<RequestScope>(latency, limit);
+            if (!scope->admitted()) {
+                rejected->add();
+                responses[4]->add();
+                res.set_header("Retry-After", "1");
+                sendJson(res, 503, {{"error", "Servidor ocupado, tente novamente em instantes"}, {"status", "error"}});
+                return;
+            }
+            
+            TraceContext traceContext(Tracer::get().sample());
+            TraceSpan span(spanName);
+            {
+                RequestScope::Activation activation(move(scope));
+                try {
+                    handler(req, res, reader...);
+                } catch (...) {
+                    responses[4]->add();
+                    throw;
+                }
+            }
+            
+            // -1: o handler não definiu o status e o httplib responde 200
+            int statusClass = (res.status == -1 ? 200 : res.status) / 100;
+            if (statusClass >= 1 && statusClass <= 5) responses[static_cast<size_t>(statusClass - 1)]->add();
+        };
+    }
+    
+    static void sendJson(Response& res, int status, const json& body) {
+        res.status = status;
+        res.set_content(body.dump(), "application/json");
+    }
+    
+    static void sendQueueFull(Response& res) {
+        res.set_header("Retry-After", "5");
+        sendJson(res, 503, {{"error", "Fila de geração cheia, tente novamente em instantes"}, {"status", "error"}});
+    }
+    
+    SingleFlight<string> responseFlight;
+    
+    // Recebe cada seção da resposta ("command", "text", "sentiment" ou
+    // "entities") assim que fica pronta. Devolver false (cliente
+    // desconectado) interrompe o cálculo das seções seguintes. O texto pode
+    // estar na arena da requisição: copie se precisar guardá-lo.
+    using SectionSink = function<bool(const char* section, string_view text)>;
+    
+    // Junta as seções na ordem da resposta completa, independente da ordem
+    // em que ficam prontas
+    class ResponseSections {
+    private:
+        static constexpr array<const char*, 4> ORDER = {"command", "text", "sentiment", "entities"};
+        array<pmr::string, ORDER.size()> parts;
+        
+    public:
+        explicit ResponseSections(pmr::memory_resource* memory)
+            : parts{pmr::string(memory), pmr::string(memory), pmr::string(memory), pmr::string(memory)} {}
+        
+        SectionSink sink() {
+            return [this](const char* section, string_view text) {
+                for (size_t i = 0; i < ORDER.size(); ++i) {
+                    if (strcmp(section, ORDER[i]) == 0) parts[i] += text;
+                }
+                return true;
+            };
+        }
+        
+        // Resposta final num buffer alocado uma única vez, no tamanho exato
+        string join() const {
+            size_t size = 0;
+            for (const auto& text : parts) size += text.size();
+            string response;
+            response.reserve(size);
+            for (const auto& text : parts) response += text;
+            return response;
+        }
+    };
+    
+    // Pedidos idênticos simultâneos compartilham uma única resposta. Tudo o
+    // que é temporário (tokens, entidades, seções) fica na arena da
+    // requisição; só a resposta final vai para o heap.
+    string generateResponse(const string& input) {
+        TraceSpan span("generate_response");
+        return responseFlight.run(input, [&] {
+            RequestArena arena;
+            ResponseSections sections(arena.memory());
+            computeResponse(input, arena.memory(), sections.sink());
+            return sections.join();
+        });
+    }
+    
+    // Análises NLP da entrada, calculadas só quando algum handler as pede
+    class LazyAnalysis {
+    private:
+        NLPProcessor& nlp;
+        const string& input;
+        pmr::memory_resource* memory;
+        optional<double> sentiment;
+        optional<EntityMatches> entities;
+        
+    public:
+        LazyAnalysis(NLPProcessor& nlp, const string& input, pmr::memory_resource* memory)
+            : nlp(nlp), input(input), memory(memory) {}
+        
+        pmr::memory_resource* arena() const {
+            return memory;
+        }
+        
+        double getSentiment() {
+            if (!sentiment) sentiment = nlp.analyzeSentiment(input, memory);
+            return *sentiment;
+        }
+        
+        // Intervalos de `input`
+        const EntityMatches& getEntities() {
+            if (!entities) entities = nlp.findEntities(input, memory);
+            return *entities;
+        }
+    };
+    
+    static const char* intentName(Intent intent) {
+        switch (intent) {
+            case Intent::CreatePresentation: return "create_presentation";
+            case Intent::CreateSpreadsheet: return "create_spreadsheet";
+            case Intent::Chat: return "chat";
+        }
+        return "chat";
+    }
+    
+    Intent routeIntent(const string& input) {
+        TraceSpan span("route_intent");
+        return router.route(input);
+    }
+    
+    void computeResponse(const string& input, pmr::memory_resource* memory, const SectionSink& emit) {
+        computeResponse(input, routeIntent(input), memory, emit);
+    }
+    
+    void computeResponse(const string& input, Intent intent, pmr::memory_resource* memory, const SectionSink& emit) {
+        // Comandos não usam nenhuma análise NLP
+        switch (intent) {
+            case Intent::CreatePresentation:
+                emit("command", handlePPTRequest(input));
+                return;
+            case Intent::CreateSpreadsheet:
+                emit("command", handleXLSRequest(input));
+                return;
+            case Intent::Chat:
+                break;
+        }
+        
+        LazyAnalysis analysis(nlp, input, memory);
+        handleChatRequest(input, analysis, emit);
+    }
+    
+    // As análises rápidas saem primeiro; o texto do modelo, que é a parte
+    // lenta, por último
+    void handleChatRequest(const string& input, LazyAnalysis& analysis, const SectionSink& emit) {
+        pmr::string section(analysis.arena());
+        section.reserve(256);
+        
+        // Adicionar análise de sentimentos
+        double sentiment = analysis.getSentiment();
+        section += "\n\nAnálise de Sentimento: ";
+        if (sentiment > 0.3) {
+            section.append(theme.success).append("Positivo");
+        } else if (sentiment < -0.3) {
+            section.append(theme.error).append("Negativo");
+        } else {
+            section.append(theme.text).append("Neutro");
+        }
+        section += COLOR_RESET;
+        if (!emit("sentiment", section)) return;
+        
+        // Adicionar entidades encontradas
+        const auto& entities = analysis.getEntities();
+        if (!entities.empty()) {
+            section = "\nEntidades Encontradas:\n";
+            for (const auto& match : entities) {
+                section.append(" - ").append(theme.accent).append(match.type).append(COLOR_RESET).append(": ");
+                section.append(input, match.start, match.end - match.start).append("\n");
+            }
+            if (!emit("entities", section)) return;
+        }
+        
+        emit("text", nlp.processText(input));
+    }
+    
+    // Um evento Server-Sent Events; o JSON em `data` nunca tem quebra de linha
+    static bool writeEvent(DataSink& sink, const char* event, const json& data) {
+        string frame = "event: ";
+        frame += event;
+        frame += "\ndata: ";
+        frame += data.dump();
+        frame += "\n\n";
+        return sink.write(frame.data(), frame.size());
+    }
+    
+    // Resultado de um item do /api/process_batch: a mesma resposta do
+    // /api/process mais a intenção e, em conversas, o sentimento numérico e
+    // as entidades
+    json analyzeBatchItem(const string& input) {
+        RequestArena arena;
+        Intent intent = routeIntent(input);
+        json item = {{"intent", intentName(intent)}};
+        ResponseSections sections(arena.memory());
+        if (intent == Intent::Chat) {
+            LazyAnalysis analysis(nlp, input, arena.memory());
+            handleChatRequest(input, analysis, sections.sink());
+            item["sentiment"] = analysis.getSentiment();
+            json entities = json::array();
+            for (const auto& match : analysis.getEntities()) {
+                entities.push_back({{"type", match.type}, {"value", input.substr(match.start, match.end - match.start)}});
+            }
+            item["entities"] = move(entities);
+        } else {
+            computeResponse(input, intent, arena.memory(), sections.sink());
+        }
+        item["response"] = sections.join();
+        return item;
+    }
+    
+    string handlePPTRequest(const string& input) {
+        // Extrair tópicos para slides (simplificado)
+        vector<string> slides;
+        size_t pos = input.find("slides:");
+        if (pos != string::npos) {
+            string slideContent = input.substr(pos + 7);
+            size_t start = 0;
+            size_t end = slideContent.find(";");
+            
+            while (end != string::npos) {
+                slides.push_back(slideContent.substr(start, end - start));
+                start = end + 1;
+                end = slideContent.find(";", start);
+            }
+            slides.push_back(slideContent.substr(start));
+        } else {
+            // Slides padrão se não especificado
+            slides = {
+                "Título da Apresentação",
+                "Tópico 1: Introdução",
+                "Tópico 2: Desenvolvimento",
+                "Tópico 3: Conclusão"
+            };
+        }
+        
+        auto jobId = submitPPTXJob(move(slides));
+        if (!jobId) {
+            return theme.error + "Fila de geração cheia, tente novamente em instantes" + COLOR_RESET;
+        }
+        return theme.success + "Apresentação em geração. Acompanhe em /api/jobs/" + *jobId +
+               " e baixe em /api/jobs/" + *jobId + "/download" + COLOR_RESET;
+    }
+    
+    string handleXLSRequest(const string& input) {
+        // Extrair dados para planilha (simplificado)
+        vector<vector<string>> data;
+        size_t pos = input.find("dados:");
+        if (pos != string::npos) {
+            string tableContent = input.substr(pos + 6);
+            size_t row_start = 0;
+            size_t row_end = tableContent.find("|");
+            
+            while (row_end != string::npos) {
+                string row = tableContent.substr(row_start, row_end - row_start);
+                vector<string> cells;
+                size_t cell_start = 0;
+                size_t cell_end = row.find(",");
+                
+                while (cell_end != string::npos) {
+                    cells.push_back(row.substr(cell_start, cell_end - cell_start));
+                    cell_start = cell_end + 1;
+                    cell_end = row.find(",", cell_start);
+                }
+                cells.push_back(row.substr(cell_start));
+                
+                data.push_back(cells);
+                row_start = row_end + 1;
+                row_end = tableContent.find("|", row_start);
+            }
+        } else {
+            // Dados padrão se não especificado
+            data = {
+                {"Nome", "Idade", "Cidade"},
+                {"João", "25", "São Paulo"},
+                {"Maria", "30", "Rio de Janeiro"},
+                {"Carlos", "22", "Belo Horizonte"}
+            };
+        }
+        
+        try {
+            checkBufferedXLSX(data);
+        } catch (const length_error& e) {
+            return theme.error + e.what() + COLOR_RESET;
+        }
+        auto jobId = submitXLSXJob(move(data));
+        if (!jobId) {
+            return theme.error + "Fila de geração cheia, tente novamente em instantes" + COLOR_RESET;
+        }
+        return theme.success + "Planilha em geração. Acompanhe em /api/jobs/" + *jobId +
+               " e baixe em /api/jobs/" + *jobId + "/download" + COLOR_RESET;
+    }
+    
+    // Página estática com a versão gzip pronta, para não comprimir a cada
+    // requisição
+    struct StaticAsset {
+        string raw;
+        string gzipped;
+        string etag;      // cada codificação tem o seu: são bytes diferentes
+        string gzipEtag;
+    };
+    
+    shared_ptr<const StaticAsset> indexPage;
+    
+    // gzip = cabeçalho fixo + deflate "raw" + CRC32 e tamanho (little-endian)
+    static shared_ptr<const StaticAsset> makeAsset(string_view content) {
+        auto asset = make_shared<StaticAsset>();
+        asset->raw = string(content);
+        PrecompressedPart part = PrecompressedPart::compress(content);
+        
+        static constexpr unsigned char GZIP_HEADER[] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 2, 3};
+        string& out = asset->gzipped;
+        out.reserve(sizeof(GZIP_HEADER) + part.deflated.size() + 8);
+        out.append(reinterpret_cast<const char*>(GZIP_HEADER), sizeof(GZIP_HEADER));
+        out += part.deflated;
+        auto appendLE32 = [&out](uint32_t value) {
+            for (int i = 0; i < 4; ++i) out += static_cast<char>((value >> (8 * i)) & 0xff);
+        };
+        appendLE32(part.crc);
+        appendLE32(static_cast<uint32_t>(part.size));
+        
+        stringstream etag;
+        etag << hex << part.crc << '-' << part.size;
+        asset->etag = '"' + etag.str() + '"';
+        asset->gzipEtag = '"' + etag.str() + "-gz\"";
+        return asset;
+    }
+    
+    static void sendAsset(Response& res, shared_ptr<const StaticAsset> asset, bool gzip) {
+        const string* body = gzip ? &asset->gzipped : &asset->raw;
+        res.set_content_provider(body->size(), "text/html; charset=utf-8",
+            [asset, body](size_t offset, size_t length, DataSink& sink) {
+                return sink.write(body->data() + offset, length);
+            });
+    }
+    
+    // Envia um arquivo gerado em memória direto do buffer, sem cópia extra
+    void sendArchive(Response& res, shared_ptr<const string> content, const string& filename,
+                     const string& contentType) {
+        res.set_header("Content-Disposition", "attachment; filename=" + filename);
+        res.set_content_provider(content->size(), contentType,
+            [content](size_t offset, size_t length, DataSink& sink) {
+                return sink.write(content->data() + offset, length);
+            });
+    }
+    
+public:
+    explicit PauloRobertoAI(ServerConfig serverConfig = {})
+        : config(move(serverConfig)), indexPage(makeAsset(INDEX_HTML)) {
+        Tracer::get().setSampleEvery(config.traceSampleEvery);
+        for (const auto& [route, limit] : config.routeLimits) {
+            routeLimits.emplace(route, make_unique<ConcurrencyLimit>(limit));
+        }
+        
+        // Valores lidos na hora da coleta
+        auto& telemetry = Telemetry::get();
+        telemetry.gauge("paulo_job_queue_depth", "Jobs de geração aguardando na fila", [this] {
+            return static_cast<double>(jobs.queueDepth());
+        });
+        telemetry.gauge("paulo_job_retained_bytes", "Bytes dos jobs terminados guardados para download", [this] {
+            return static_cast<double>(jobs.retainedByteCount());
+        });
+        telemetry.gauge("paulo_inference_queue_depth", "Pedidos aguardando lote de inferência", [this] {
+            auto metrics = nlp.inferenceMetrics();
+            return metrics ? static_cast<double>(metrics->queueDepth) : 0.0;
+        });
+        telemetry.gauge("paulo_nlp_coalesced_requests", "Pedidos de processamento agrupados com um idêntico em andamento", [this] {
+            return static_cast<double>(nlp.coalescedRequests());
+        });
+        telemetry.gauge("paulo_response_coalesced_requests", "Respostas agrupadas com uma idêntica em andamento", [this] {
+            return static_cast<double>(responseFlight.coalescedCount());
+        });
+    }
+    
+    // Registra as rotas num servidor; com vários listeners cada um tem o seu
+    void registerRoutes(Server& server) {
+        // Página inicial, comprimida uma vez na inicialização
+        server.Get("/", timed("GET", "/", [this](const Request& req, Response& res) {
+            res.set_header("Cache-Control", "public, max-age=300");
+            res.set_header("Vary", "Accept-Encoding");
+            bool gzip = acceptsGzip(req.get_header_value("Accept-Encoding"));
+            if (notModified(req, res, gzip ? indexPage->gzipEtag : indexPage->etag)) return;
+            
+            if (gzip) res.set_header("Content-Encoding", "gzip");
+            sendAsset(res, indexPage, gzip);
+        }));
+        
+        // Métricas no formato texto do Prometheus
+        server.Get("/metrics", [](const Request&, Response& res) {
+            res.set_content(Telemetry::get().renderPrometheus(), "text/plain; version=0.0.4; charset=utf-8");
+        });
+        
+        // Traces recentes no formato trace_event do Chrome (abrir no Perfetto).
+        // ?trace=<id> filtra um trace e ?limit=<n> limita o número de spans.
+        // Só existe com admin_token configurado e exige
+        // "Authorization: Bearer <token>"; o endereço de origem não basta,
+        // porque atrás de um proxy local toda conexão vem de 127.0.0.1.
+        if (!config.adminToken.empty()) {
+            server.Get("/admin/traces", [this](const Request& req, Response& res) {
+                if (!isAdmin(req)) {
+                    res.set_header("WWW-Authenticate", "Bearer");
+                    sendJson(res, 401, {{"error", "Token de administração inválido"}, {"status", "error"}});
+                    return;
+                }
+                
+                try {
+                    uint64_t trace = req.has_param("trace") ? stoull(req.get_param_value("trace")) : 0;
+                    size_t limit = req.has_param("limit") ? stoul(req.get_param_value("limit")) : 10000;
+                    res.set_header("Content-Disposition", "attachment; filename=\"traces.json\"");
+                    sendJson(res, 200, Tracer::get().renderChromeTrace(trace, limit));
+                } catch (const exception& e) {
+                    sendJson(res, 400, {{"error", e.what()}, {"status", "error"}});
+                }
+            });
+        }
+        
+        // Vivacidade: responde assim que o servidor está ouvindo
+        server.Get("/healthz", timed("GET", "/healthz", [](const Request&, Response& res) {
+            sendJson(res, 200, {{"status", "ok"}});
+        }));
+        
+        // Prontidão: só depois de cache, dicionários e modelo carregados e
+        // do aquecimento do modelo
+        server.Get("/readyz", timed("GET", "/readyz", [&](const Request&, Response& res) {
+            auto timings = nlp.startupTimings();
+            if (!timings) {
+                sendJson(res, 503, {{"status", "starting"}, {"stage", nlp.startupStage()}});
+                return;
+            }
+            
+            sendJson(res, 200, {
+                {"status", "ready"},
+                {"model_loaded", nlp.inferenceEngine().has_value()},
+                {"startup_ms", {
+                    {"cache", timings->cacheOpen},
+                    {"dictionaries", timings->dictionaries},
+                    {"model", timings->modelLoad},
+                    {"warmup", timings->warmup},
+                    {"total", timings->total}
+                }}
+            });
+        }));
+        
+        server.Post("/api/process", timed("POST", "/api/process", [&](const Request& req, Response& res) {
+            try {
+                auto j = json::parse(req.body);
+                string input = j["input"];
+                string response = generateResponse(input);
+                
+                json result = {
+                    {"response", response},
+                    {"status", "success"}
+                };
+                res.set_content(result.dump(), "application/json");
+            } catch (const exception& e) {
+                json error = {
+                    {"error", e.what()},
+                    {"status", "error"}
+                };
+                res.status = 400;
+                res.set_content(error.dump(), "application/json");
+            }
+        }));
+        
+        // Mesma entrada do /api/process, mas a resposta sai como Server-Sent
+        // Events: "intent" logo após o roteamento, uma "section" para cada
+        // parte pronta ({"section": nome, "text": ...}) e "done" no fim (ou
+        // "error"). Sem coalescência: cada conexão calcula a sua resposta.
+        server.Post("/api/process_stream", timed("POST", "/api/process_stream", [&](const Request& req, Response& res) {
+            string input;
+            try {
+                input = json::parse(req.body).at("input").get<string>();
+            } catch (const exception& e) {
+                sendJson(res, 400, {{"error", e.what()}, {"status", "error"}});
+                return;
+            }
+            
+            res.set_header("Cache-Control", "no-cache");
+            res.set_header("X-Accel-Buffering", "no");  // proxies não devem segurar os eventos
+            res.set_chunked_content_provider("text/event-stream",
+                [this, input = move(input), trace = Tracer::currentTrace(),
+                 scope = RequestScope::current()](size_t, DataSink& sink) {
+                    TraceContext traceContext(trace);
+                    TraceSpan span("stream_response");
+                    try {
+                        Intent intent = routeIntent(input);
+                        if (!writeEvent(sink, "intent", {{"intent", intentName(intent)}})) return false;
+                        
+                        RequestArena arena;
+                        bool connected = true;
+                        computeResponse(input, intent, arena.memory(), [&](const char* section, string_view text) {
+                            connected = writeEvent(sink, "section", {{"section", section}, {"text", text}});
+                            return connected;
+                        });
+                        if (!connected) return false;
+                        writeEvent(sink, "done", {{"status", "success"}});
+                    } catch (const exception& e) {
+                        writeEvent(sink, "error", {{"error", e.what()}, {"status", "error"}});
+                    }
+                    sink.done();
+                    return true;
+                });
+        }));
+        
+        // Muitos textos numa requisição, uma linha NDJSON por item
+        // ({"input": "...", "id": opcional}). Cada linha vai para o WorkerPool
+        // assim que chega, sem esperar o resto do corpo; os resultados saem
+        // em NDJSON na ordem da entrada, cada um assim que ele e os anteriores
+        // ficam prontos.
+        server.Post("/api/process_batch", timed<Server::HandlerWithContentReader>("POST", "/api/process_batch",
+            [&](const Request&, Response& res, const ContentReader& contentReader) {
+            WorkerPool& pool = WorkerPool::shared();
+            auto results = make_shared<vector<future<string>>>();
+            auto cancelled = make_shared<atomic<bool>>(false);
+            auto trace = Tracer::currentTrace();
+            string failure;
+            
+            auto submitLine = [&](string_view line) {
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                if (line.find_first_not_of(" \t") == string_view::npos) return true;
+                if (results->size() >= MAX_BATCH_ITEMS) {
+                    failure = "Lote com mais de " + to_string(MAX_BATCH_ITEMS) + " itens";
+                    return false;
+                }
+                
+                BatchItemReader item = BatchItemReader::parse(line);
+                results->push_back(pool.submit([this, index = results->size(), input = move(item.input),
+                                                id = move(item.id), error = move(item.error), cancelled, trace] {
+                    if (*cancelled) return string();
+                    TraceContext traceContext(trace);
+                    TraceSpan span("batch_item");
+                    json result;
+                    if (input) {
+                        try {
+                            result = analyzeBatchItem(*input);
+                            result["status"] = "success";
+                        } catch (const exception& e) {
+                            result = {{"error", e.what()}, {"status", "error"}};
+                        }
+                    } else {
+                        result = {{"error", error}, {"status", "error"}};
+                    }
+                    result["index"] = index;
+                    if (!id.is_null()) result["id"] = id;
+                    return result.dump() + "\n";
+                }));
+                return true;
+            };
+            
+            // Linhas podem chegar partidas entre chunks; o pedaço incompleto
+            // espera em `partial`
+            string partial;
+            bool complete = contentReader([&](const char* data, size_t length) {
+                string_view chunk(data, length);
+                size_t newline;
+                while ((newline = chunk.find('\n')) != string_view::npos) {
+                    bool ok;
+                    if (partial.empty()) {
+                        ok = submitLine(chunk.substr(0, newline));
+                    } else {
+                        partial.append(chunk.substr(0, newline));
+                        ok = submitLine(partial);
+                        partial.clear();
+                    }
+                    if (!ok) return false;
+                    chunk.remove_prefix(newline + 1);
+                }
+                if (partial.size() + chunk.size() > MAX_BATCH_LINE) {
+                    failure = "Linha com mais de " + to_string(MAX_BATCH_LINE) + " bytes";
+                    return false;
+                }
+                partial.append(chunk);
+                return true;
+            });
+            if (complete && !partial.empty()) complete = submitLine(partial);
+            
+            if (!complete) {
+                *cancelled = true;
+                if (failure.empty()) {
+                    sendJson(res, 400, {{"error", "Erro ao ler o corpo da requisição"}, {"status", "error"}});
+                } else {
+                    sendJson(res, 413, {{"error", failure}, {"status", "error"}});
+                }
+                return;
+            }
+            
+            // O provider segura o RequestScope: a latência e o limite de
+            // concorrência da rota cobrem o lote inteiro, não só a leitura
+            res.set_chunked_content_provider("application/x-ndjson",
+                [results, cancelled, scope = RequestScope::current()](size_t, DataSink& sink) {
+                    for (auto& result : *results) {
+                        string line = result.get();
+                        if (!sink.write(line.data(), line.size())) {
+                            *cancelled = true;  // cliente desconectou: o resto do lote é descartado
+                            return false;
+                        }
+                    }
+                    sink.done();
+                    return true;
+                },
+                [cancelled](bool success) {
+                    if (!success) *cancelled = true;  // a resposta não chegou a ser enviada inteira
+                });
+        }));
+        
+        // Parâmetros e métricas do agendador de inferência (tamanho dos lotes,
+        // tempo na fila)
+        server.Get("/api/inference/metrics", timed("GET", "/api/inference/metrics", [&](const Request&, Response& res) {
+            auto metrics = nlp.inferenceMetrics();
+            auto tunables = nlp.inferenceTunables();
+            if (!metrics || !tunables) {
+                sendJson(res, 200, {{"model_loaded", false}});
+                return;
+            }
+            
+            sendJson(res, 200, {
+                {"model_loaded", true},
+                {"engine", nlp.inferenceEngine().value_or("")},
+                {"tunables", {
+                    {"max_batch", tunables->maxBatch},
+                    {"max_wait_us", tunables->maxWait.count()},
+                    {"max_sequence", tunables->maxSequence},
+                    {"max_queue", tunables->maxQueue},
+                    {"vocabulary_size", tunables->vocabularySize},
+                    {"intra_op_threads", tunables->intraOpThreads},
+                    {"workers", tunables->workers}
+                }},
+                {"metrics", {
+                    {"requests", metrics->requests},
+                    {"batches", metrics->batches},
+                    {"rejected", metrics->rejected},
+                    {"queue_depth", metrics->queueDepth},
+                    {"max_batch_size", metrics->maxBatchSize},
+                    {"mean_batch_size", metrics->meanBatchSize},
+                    {"mean_queue_us", metrics->meanQueueMicros},
+                    {"max_queue_us", metrics->maxQueueMicros},
+                    {"mean_forward_us", metrics->meanForwardMicros}
+                }}
+            });
+        }));
+        
+        server.Get("/api/generate_pptx", timed("GET", "/api/generate_pptx", [&](const Request& req, Response& res) {
+            vector<string> slides = {
+                "Título da Apresentação",
+                "Slide 1: Introdução",
+                "Slide 2: Desenvolvimento",
+                "Slide 3: Conclusão"
+            };
+            
+            string key = ArtifactCache::keyFor(slides);
+            if (notModified(req, res, ArtifactCache::etagFor(key))) return;
+            
+            // Em cache, o download custa só o hash das entradas
+            auto content = artifacts.get(key);
+            if (!content) {
+                auto slot = jobs.tryAcquireSlot();
+                if (!slot) {
+                    sendQueueFull(res);
+                    return;
+                }
+                content = cachedPPTX(key, slides);
+            }
+            sendArchive(res, content, fileGen.generateFilename("apresentacao", ".pptx"), PPTX_CONTENT_TYPE);
+        }));
+        
+        server.Get("/api/generate_xlsx", timed("GET", "/api/generate_xlsx", [&](const Request& req, Response& res) {
+            vector<vector<string>> data = {
+                {"Nome", "Idade", "Cidade"},
+                {"João", "25", "São Paulo"},
+                {"Maria", "30", "Rio de Janeiro"},
+                {"Carlos", "22", "Belo Horizonte"}
+            };
+            
+            string key = ArtifactCache::keyFor(data);
+            if (notModified(req, res, ArtifactCache::etagFor(key))) return;
+            
+            string filename = fileGen.generateFilename("planilha", ".xlsx");
+            if (auto content = artifacts.get(key)) {
+                sendArchive(res, content, filename, XLSX_CONTENT_TYPE);
+                return;
+            }
+            
+            // O slot fica com o provider até o último chunk ser enviado
+            shared_ptr<JobQueue::Slot> slot = jobs.tryAcquireSlot();
+            if (!slot) {
+                sendQueueFull(res);
+                return;
+            }
+            
+            // Transmite em chunks: os primeiros bytes saem antes da última linha
+            // ser gerada. Uma cópia vai para o cache se couber nele.
+            auto rows = make_shared<vector<vector<string>>>(move(data));
+            res.set_header("Content-Disposition", "attachment; filename=" + filename);
+            res.set_chunked_content_provider(XLSX_CONTENT_TYPE,
+                [this, rows, slot, key, scope = RequestScope::current()](size_t, DataSink& sink) {
+                    auto copy = make_shared<string>();
+                    bool cacheable = true;
+                    bool ok = fileGen.generateXLSX(*rows, [&](const char* bytes, size_t size) {
+                        if (cacheable) {
+                            cacheable = copy->size() + size <= artifacts.maxEntryBytes();
+                            if (cacheable) {
+                                copy->append(bytes, size);
+                            } else {
+                                copy.reset();
+                            }
+                        }
+                        return sink.write(bytes, size);
+                    });
+                    if (ok) {
+                        if (cacheable) artifacts.put(key, move(copy));
+                        sink.done();
+                    }
+                    return ok;
+                });
+        }));
+        
+        // Geração assíncrona: POST devolve o id do job, que é consultado
+        // (com long-poll opcional via ?wait=segundos, até 10) e baixado depois
+        server.Post("/api/jobs", timed("POST", "/api/jobs", [&](const Request& req, Response& res) {
+            try {
+                auto j = json::parse(req.body);
+                string type = j.value("type", "");
+                
+                optional<string> jobId;
+                if (type == "pptx") {
+                    jobId = submitPPTXJob(j.value("slides", vector<string>{"Título da Apresentação"}));
+                } else if (type == "xlsx") {
+                    auto data = j.value("data", vector<vector<string>>{});
+                    checkBufferedXLSX(data);
+                    jobId = submitXLSXJob(move(data));
+                } else {
+                    sendJson(res, 400, {{"error", "Tipo de documento inválido (use pptx ou xlsx)"}, {"status", "error"}});
+                    return;
+                }
+                
+                if (!jobId) {
+                    sendQueueFull(res);
+                    return;
+                }
+                sendJson(res, 202, {
+                    {"job_id", *jobId},
+                    {"status", JobQueue::statusName(JobQueue::JobStatus::Queued)},
+                    {"status_url", "/api/jobs/" + *jobId},
+                    {"download_url", "/api/jobs/" + *jobId + "/download"}
+                });
+            } catch (const length_error& e) {
+                sendJson(res, 413, {{"error", string(e.what()) + "; planilhas maiores não são geradas em jobs"},
+                                    {"status", "error"}});
+            } catch (const exception& e) {
+                sendJson(res, 400, {{"error", e.what()}, {"status", "error"}});
+            }
+        }));
+        
+        server.Get(R"(/api/jobs/([0-9a-f]+))", timed("GET", "/api/jobs/:id", [&](const Request& req, Response& res) {
+            long waitSeconds = 0;
+            if (req.has_param("wait")) {
+                try {
+                    waitSeconds = clamp(stol(req.get_param_value("wait")), 0L, MAX_JOB_WAIT_SECONDS);
+                } catch (const exception&) {
+                    waitSeconds = 0;
+                }
+            }
+            
+            // Sem vaga para esperar: responde o estado atual e pede para o
+            // cliente voltar em seguida
+            ConcurrencyLimit::Slot waiter(waitSeconds > 0 ? &jobWaiters : nullptr);
+            auto job = jobs.status(req.matches[1], chrono::seconds(waiter.admitted ? waitSeconds : 0));
+            if (!job) {
+                sendJson(res, 404, {{"error", "Job não encontrado ou expirado"}, {"status", "error"}});
+                return;
+            }
+            
+            json body = {{"job_id", job->id}, {"status", JobQueue::statusName(job->status)}};
+            if (job->status == JobQueue::JobStatus::Done) {
+                body["download_url"] = "/api/jobs/" + job->id + "/download";
+            } else if (job->status == JobQueue::JobStatus::Failed) {
+                body["error"] = job->error;
+            } else if (!waiter.admitted) {
+                res.set_header("Retry-After", "1");
+            }
+            sendJson(res, 200, body);
+        }));
+        
+        server.Get(R"(/api/jobs/([0-9a-f]+)/download)", timed("GET", "/api/jobs/:id/download", [&](const Request& req, Response& res) {
+            auto job = jobs.status(req.matches[1]);
+            if (!job) {
+                sendJson(res, 404, {{"error", "Job não encontrado ou expirado"}, {"status", "error"}});
+                return;
+            }
+            
+            switch (job->status) {
+                case JobQueue::JobStatus::Done:
+                    if (notModified(req, res, job->artifact.etag)) break;
+                    sendArchive(res, job->artifact.content,
+                                job->artifact.filename, job->artifact.contentType);
+                    break;
+                case JobQueue::JobStatus::Failed:
+                    sendJson(res, 500, {{"error", job->error}, {"status", "error"}});
+                    break;
+                default:
+                    sendJson(res, 409, {{"job_id", job->id}, {"status", JobQueue::statusName(job->status)}});
+            }
+        }));
+    }
+    
+    // Abre as portas e atende até o servidor parar; lança runtime_error se
+    // alguma porta não puder ser aberta, para o processo sair com erro
+    void start() {
+        int port = config.port;
+        cout << theme.background << theme.primary 
+             << "Paulo Roberto AI iniciando na porta " << port << COLOR_RESET << endl;
+        
+        // Cria as threads do pool de análise antes de fixar CPUs, para que
+        // elas não herdem a afinidade de um listener
+        WorkerPool::shared();
+        
+        size_t listeners = config.listeners;
+        size_t threadsPerListener = max<size_t>(1, config.threads / listeners);
+        for (size_t i = 0; i < listeners; ++i) {
+            auto server = make_unique<Server>();
+            server->new_task_queue = [threadsPerListener] { return new ThreadPool(threadsPerListener); };
+            server->set_keep_alive_timeout(config.keepAliveTimeout);
+            server->set_keep_alive_max_count(config.keepAliveMaxCount);
+            server->set_read_timeout(config.readTimeout, 0);
+            server->set_write_timeout(config.writeTimeout, 0);
+            server->set_payload_max_length(config.maxBodyBytes);
+            if (listeners > 1) {
+                // O kernel distribui as conexões entre os sockets da mesma porta
+                server->set_socket_options([](socket_t sock) {
+                    int yes = 1;
+                    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+                    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&yes), sizeof(yes));
+                });
+            }
+            registerRoutes(*server);
+            
+            if (!server->bind_to_port(config.host, port))
+                throw runtime_error("Não foi possível abrir a porta " + config.host + ":" + to_string(port));
+            servers.push_back(move(server));
+        }
+        
+        // O modelo continua carregando em segundo plano; /readyz avisa quando terminar
+        cout << theme.secondary << "Servidor ouvindo " << chrono::duration<double, milli>(chrono::steady_clock::now() - processStart).count()
+             << " ms após o início do processo" << COLOR_RESET << endl;
+        if (listeners > 1) {
+            cout << theme.secondary << listeners << " listeners com SO_REUSEPORT, " << threadsPerListener
+                 << " threads cada" << COLOR_RESET << endl;
+        }
+        cout << theme.secondary << "Acesse http://localhost:" << port << COLOR_RESET << endl;
+        
+        // Cada listener fixa a própria thread antes de ouvir; as threads do
+        // httplib são criadas depois e herdam a afinidade
+        auto cpuSets = config.listenerCpuSets();
+        auto listen = [this, &cpuSets](size_t i) {
+            if (i < cpuSets.size() && !pinCurrentThread(cpuSets[i])) {
+                cerr << theme.error << "Não foi possível fixar o listener " << i << " nas CPUs escolhidas"
+                     << COLOR_RESET << endl;
+            }
+            servers[i]->listen_after_bind();
+        };
+        vector<thread> others;
+        for (size_t i = 1; i < servers.size(); ++i) others.emplace_back(listen, i);
+        listen(0);
+        for (auto& other : others) other.join();
+    }
+};
@@ -0,0 +1,432 @@
+// server_config.h - Configuração do servidor (linha de comando e arquivo JSON)
+#pragma once
+
+#include "common.h"
+#include "inference.h"
+#include "artifact_cache.h"
+#include "cache.h"
+#include "job_queue.h"
+#include <pthread.h>
+#include <sched.h>
+
+// Parâmetros do servidor HTTP. Os valores vêm, em ordem de prioridade, da
+// linha de comando, do arquivo passado em --config e dos padrões abaixo.
+//
+// Exemplo de arquivo:
+//   {
+//     "port": 8080,
+//     "threads": 32,
+//     "keep_alive_timeout": 10,
+//     "max_body_bytes": 33554432,
+//     "listeners": 4,
+//     "pin_cpus": true,
+//     "route_limits": {"/api/process": 64, "/api/process_batch": 4},
+//     "engine": "onnx",
+//     "artifact_cache": {"max_bytes": 134217728, "spill_dir": "/var/cache/paulo"},
+//     "nlp_cache": {"max_bytes": 1073741824, "ttl": 604800},
+//     "jobs": {"max_pending": 128, "ttl": 300, "max_retained_bytes": 536870912},
+//     "inference": {"max_batch": 32, "workers": 2}
+//   }
+struct ServerConfig {
+    string host = "0.0.0.0";
+    int port = 8080;
+    size_t threads = max(8u, thread::hardware_concurrency());  // threads HTTP, divididas entre os listeners
+    time_t keepAliveTimeout = 5;                               // segundos ociosos antes de fechar a conexão
+    size_t keepAliveMaxCount = 100;                            // requisições por conexão
+    time_t readTimeout = 5;
+    time_t writeTimeout = 5;
+    size_t maxBodyBytes = 16 * 1024 * 1024;
+    size_t listeners = 1;                                      // > 1: sockets na mesma porta com SO_REUSEPORT
+    bool pinCpus = false;                                      // prende cada listener e suas threads a CPUs
+    vector<vector<int>> cpuSets;                               // grupos de CPUs; vazio divide as disponíveis
+    map<string, size_t> routeLimits;                           // requisições simultâneas por rota
+    uint64_t traceSampleEvery = 100;                           // 0 desliga o rastreamento
+    string engine = "auto";                                    // motor de inferência: torch, onnx ou auto
+    InferenceTunables inference;
+    ArtifactCacheBudget artifactCache;
+    NLPCacheBudget nlpCache;                                   // cache SQLite do NLP; ttl em segundos no JSON
+    string adminToken;                                         // vazio desliga /admin/traces
+    JobQueueBudget jobs;                                       // fila de geração; ttl em segundos no JSON
+    
+    // Rótulos das rotas do servidor, os mesmos usados nas métricas; são as
+    // chaves aceitas em route_limits. O PauloRobertoAI::timed() recusa rotas
+    // que não estejam aqui, para que a lista não fique desatualizada.
+    static const vector<string>& knownRoutes() {
+        static const vector<string> routes = {
+            "/", "/healthz", "/readyz", "/api/process", "/api/process_stream", "/api/process_batch",
+            "/api/inference/metrics", "/api/generate_pptx", "/api/generate_xlsx",
+            "/api/jobs", "/api/jobs/:id", "/api/jobs/:id/download"
+        };
+        return routes;
+    }
+    
+    // Lista de CPUs no formato do taskset: "0-3,8,10-11"
+    static vector<int> parseCpuList(const string& list) {
+        vector<int> cpus;
+        stringstream ss(list);
+        string range;
+        while (getline(ss, range, ',')) {
+            if (range.empty()) continue;
+            size_t dash = range.find('-');
+            int first = -1;
+            int last = -1;
+            try {
+                first = stoi(range.substr(0, dash));
+                last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+            } catch (const exception&) {
+                first = -1;
+            }
+            if (first < 0 || last < first || last >= CPU_SETSIZE) {
+                throw runtime_error("Lista de CPUs inválida: " + list);
+            }
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        if (cpus.empty()) throw runtime_error("Lista de CPUs vazia");
+        return cpus;
+    }
+    
+    // Aplica as chaves de `j` sobre a configuração atual; chaves
+    // desconhecidas são erro, para que um erro de digitação não passe
+    // despercebido
+    void apply(const json& j) {
+        if (!j.is_object()) throw runtime_error("A configuração deve ser um objeto JSON");
+        
+        for (const auto& [key, value] : j.items()) {
+            try {
+                applyOption(key, value);
+            } catch (const json::exception& e) {
+                throw runtime_error("Valor inválido para " + key + ": " + e.what());
+            }
+        }
+        validate();
+    }
+    
+    void loadFile(const string& path) {
+        ifstream file(path);
+        if (!file) {
+            throw runtime_error("Não foi possível abrir o arquivo de configuração: " + path);
+        }
+        json j;
+        try {
+            j = json::parse(file, nullptr, true, true);  // aceita comentários
+        } catch (const exception& e) {
+            throw runtime_error("Erro no arquivo de configuração " + path + ": " + e.what());
+        }
+        apply(j);
+    }
+    
+    static string usage(const string& program) {
+        return "Uso: " + program + " [porta] [opções]\n"
+               "  --config arquivo.json          configuração em JSON (as opções abaixo têm prioridade)\n"
+               "  --host endereço                endereço de escuta (padrão 0.0.0.0)\n"
+               "  --port porta                   porta HTTP (padrão 8080)\n"
+               "  --threads n                    threads HTTP no total\n"
+               "  --keep-alive-timeout s         segundos de conexão ociosa\n"
+               "  --keep-alive-max n             requisições por conexão\n"
+               "  --read-timeout s / --write-timeout s\n"
+               "  --max-body bytes               tamanho máximo do corpo\n"
+               "  --listeners n                  n sockets na mesma porta (SO_REUSEPORT)\n"
+               "  --pin-cpus                     prende cada listener a um grupo de CPUs\n"
+               "  --cpu-sets \"0-3;4-7\"           grupos de CPUs dos listeners\n"
+               "  --route-limit rota=n           requisições simultâneas numa rota (repetível)\n"
+               "  --trace-sample-every n         rastreia 1 a cada n requisições (0 desliga)\n"
+               "  --engine torch|onnx|auto       motor de inferência\n"
+               "  --artifact-cache-bytes n       memória do cache de documentos gerados\n"
+               "  --artifact-spill-dir dir       guarda no disco os documentos despejados da memória\n"
+               "  --artifact-spill-bytes n       limite do spill em disco\n"
+               "  --nlp-cache-bytes n            tamanho máximo do cache SQLite do NLP\n"
+               "  --nlp-cache-ttl s              idade máxima das entradas do cache do NLP\n"
+               "  --job-max-pending n            jobs de geração aguardando na fila\n"
+               "  --job-ttl s                    tempo que um job terminado fica disponível\n"
+               "  --job-retained-bytes n         bytes somados dos jobs terminados guardados\n"
+               "  --admin-token token            liga /admin/traces (Authorization: Bearer token);\n"
+               "                                 também lido de PAULO_ADMIN_TOKEN\n";
+    }
+    
+    // Lê --config primeiro e depois aplica as demais opções por cima. Um
+    // número solto é a porta (como o start.sh passa). O token de
+    // administração também pode vir do ambiente, para não aparecer no ps.
+    static ServerConfig fromArgs(int argc, char** argv) {
+        ServerConfig config;
+        vector<string> args(argv + 1, argv + argc);
+        if (const char* token = getenv("PAULO_ADMIN_TOKEN")) config.adminToken = token;
+        
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "--help" || args[i] == "-h") {
+                cout << usage(argv[0]);
+                exit(0);
+            }
+            if (args[i] == "--config") {
+                if (i + 1 >= args.size()) throw runtime_error("--config precisa de um arquivo");
+                config.loadFile(args[i + 1]);
+            }
+        }
+        
+        json overrides = json::object();
+        for (size_t i = 0; i < args.size(); ++i) {
+            const string& arg = args[i];
+            auto value = [&]() -> const string& {
+                if (i + 1 >= args.size()) throw runtime_error(arg + " precisa de um valor");
+                return args[++i];
+            };
+            auto number = [&]() {
+                const string& text = value();
+                size_t used = 0;
+                long long parsed = -1;
+                try {
+                    parsed = stoll(text, &used);
+                } catch (const exception&) {
+                    used = 0;
+                }
+                if (used != text.size() || parsed < 0) throw runtime_error("Valor inválido para " + arg + ": " + text);
+                return parsed;
+            };
+            
+            if (arg == "--config") {
+                ++i;  // já lido
+            } else if (!arg.empty() && isdigit(static_cast<unsigned char>(arg[0]))) {
+                --i;  // o próprio argumento é o valor
+                overrides["port"] = number();
+            } else if (arg == "--host") {
+                overrides["host"] = value();
+            } else if (arg == "--port") {
+                overrides["port"] = number();
+            } else if (arg == "--threads") {
+                overrides["threads"] = number();
+            } else if (arg == "--keep-alive-timeout") {
+                overrides["keep_alive_timeout"] = number();
+            } else if (arg == "--keep-alive-max") {
+                overrides["keep_alive_max_count"] = number();
+            } else if (arg == "--read-timeout") {
+                overrides["read_timeout"] = number();
+            } else if (arg == "--write-timeout") {
+                overrides["write_timeout"] = number();
+            } else if (arg == "--max-body") {
+                overrides["max_body_bytes"] = number();
+            } else if (arg == "--listeners") {
+                overrides["listeners"] = number();
+            } else if (arg == "--pin-cpus") {
+                overrides["pin_cpus"] = true;
+            } else if (arg == "--cpu-sets") {
+                json sets = json::array();
+                stringstream ss(value());
+                string set;
+                while (getline(ss, set, ';')) sets.push_back(set);
+                overrides["cpu_sets"] = sets;
+                overrides["pin_cpus"] = true;
+            } else if (arg == "--route-limit") {
+                const string& limit = value();
+                size_t equals = limit.rfind('=');
+                if (equals == string::npos || limit.find_first_not_of("0123456789", equals + 1) != string::npos) {
+                    throw runtime_error("Use --route-limit rota=n");
+                }
+                overrides["route_limits"][limit.substr(0, equals)] = stoull(limit.substr(equals + 1));
+            } else if (arg == "--trace-sample-every") {
+                overrides["trace_sample_every"] = number();
+            } else if (arg == "--engine") {
+                overrides["engine"] = value();
+            } else if (arg == "--artifact-cache-bytes") {
+                overrides["artifact_cache"]["max_bytes"] = number();
+            } else if (arg == "--artifact-spill-dir") {
+                overrides["artifact_cache"]["spill_dir"] = value();
+            } else if (arg == "--artifact-spill-bytes") {
+                overrides["artifact_cache"]["max_spill_bytes"] = number();
+            } else if (arg == "--nlp-cache-bytes") {
+                overrides["nlp_cache"]["max_bytes"] = number();
+            } else if (arg == "--nlp-cache-ttl") {
+                overrides["nlp_cache"]["ttl"] = number();
+            } else if (arg == "--job-max-pending") {
+                overrides["jobs"]["max_pending"] = number();
+            } else if (arg == "--job-ttl") {
+                overrides["jobs"]["ttl"] = number();
+            } else if (arg == "--job-retained-bytes") {
+                overrides["jobs"]["max_retained_bytes"] = number();
+            } else if (arg == "--admin-token") {
+                overrides["admin_token"] = value();
+            } else {
+                throw runtime_error("Opção desconhecida: " + arg);
+            }
+        }
+        config.apply(overrides);
+        return config;
+    }
+    
+    // CPUs de cada listener, ou vazio se não for para fixar
+    vector<vector<int>> listenerCpuSets() const {
+        if (!pinCpus) return {};
+        if (!cpuSets.empty()) {
+            vector<vector<int>> sets;
+            for (size_t i = 0; i < listeners; ++i) sets.push_back(cpuSets[i % cpuSets.size()]);
+            return sets;
+        }
+        
+        // Sem grupos explícitos: as CPUs permitidas ao processo são divididas
+        // em faixas contíguas, uma por listener
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return {};
+        vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+        if (cpus.empty()) return {};
+        
+        vector<vector<int>> sets(listeners);
+        for (size_t i = 0; i < listeners; ++i) {
+            size_t begin = i * cpus.size() / listeners;
+            size_t end = max(begin + 1, (i + 1) * cpus.size() / listeners);
+            for (size_t k = begin; k < end; ++k) sets[i].push_back(cpus[k % cpus.size()]);
+        }
+        return sets;
+    }
+    
+private:
+    void applyOption(const string& key, const json& value) {
+        if (key == "host") {
+            host = value.get<string>();
+        } else if (key == "port") {
+            port = value.get<int>();
+        } else if (key == "threads") {
+            threads = value.get<size_t>();
+        } else if (key == "keep_alive_timeout") {
+            keepAliveTimeout = value.get<time_t>();
+        } else if (key == "keep_alive_max_count") {
+            keepAliveMaxCount = value.get<size_t>();
+        } else if (key == "read_timeout") {
+            readTimeout = value.get<time_t>();
+        } else if (key == "write_timeout") {
+            writeTimeout = value.get<time_t>();
+        } else if (key == "max_body_bytes") {
+            maxBodyBytes = value.get<size_t>();
+        } else if (key == "listeners") {
+            listeners = value.get<size_t>();
+        } else if (key == "pin_cpus") {
+            pinCpus = value.get<bool>();
+        } else if (key == "cpu_sets") {
+            cpuSets.clear();
+            for (const auto& list : value) cpuSets.push_back(parseCpuList(list.get<string>()));
+        } else if (key == "route_limits") {
+            for (const auto& [route, limit] : value.items()) routeLimits[route] = limit.get<size_t>();
+        } else if (key == "trace_sample_every") {
+            traceSampleEvery = value.get<uint64_t>();
+        } else if (key == "engine") {
+            engine = value.get<string>();
+        } else if (key == "inference") {
+            applyInference(value);
+        } else if (key == "artifact_cache") {
+            applyArtifactCache(value);
+        } else if (key == "nlp_cache") {
+            applyNlpCache(value);
+        } else if (key == "jobs") {
+            applyJobs(value);
+        } else if (key == "admin_token") {
+            adminToken = value.get<string>();
+        } else {
+            throw runtime_error("Opção de configuração desconhecida: " + key);
+        }
+    }
+    
+    void applyInference(const json& j) {
+        for (const auto& [key, value] : j.items()) {
+            if (key == "max_batch") {
+                inference.maxBatch = value.get<size_t>();
+            } else if (key == "max_wait_us") {
+                inference.maxWait = chrono::microseconds(value.get<int64_t>());
+            } else if (key == "max_sequence") {
+                inference.maxSequence = value.get<size_t>();
+            } else if (key == "max_queue") {
+                inference.maxQueue = value.get<size_t>();
+            } else if (key == "intra_op_threads") {
+                inference.intraOpThreads = value.get<int>();
+            } else if (key == "workers") {
+                inference.workers = value.get<size_t>();
+            } else if (key == "warmup_runs") {
+                inference.warmupRuns = value.get<size_t>();
+            } else {
+                throw runtime_error("Opção de inferência desconhecida: " + key);
+            }
+        }
+    }
+    
+    void applyArtifactCache(const json& j) {
+        for (const auto& [key, value] : j.items()) {
+            if (key == "max_bytes") {
+                artifactCache.maxBytes = value.get<size_t>();
+            } else if (key == "spill_dir") {
+                artifactCache.spillDir = value.get<string>();
+            } else if (key == "max_spill_bytes") {
+                artifactCache.maxSpillBytes = value.get<size_t>();
+            } else {
+                throw runtime_error("Opção do cache de documentos desconhecida: " + key);
+            }
+        }
+    }
+    
+    void applyNlpCache(const json& j) {
+        for (const auto& [key, value] : j.items()) {
+            if (key == "max_bytes") {
+                nlpCache.maxBytes = value.get<uint64_t>();
+            } else if (key == "ttl") {
+                nlpCache.ttl = chrono::seconds(value.get<int64_t>());
+            } else {
+                throw runtime_error("Opção do cache do NLP desconhecida: " + key);
+            }
+        }
+    }
+    
+    void applyJobs(const json& j) {
+        for (const auto& [key, value] : j.items()) {
+            if (key == "max_pending") {
+                jobs.maxPending = value.get<size_t>();
+            } else if (key == "ttl") {
+                jobs.ttl = chrono::seconds(value.get<int64_t>());
+            } else if (key == "max_retained_bytes") {
+                jobs.maxRetainedBytes = value.get<size_t>();
+            } else {
+                throw runtime_error("Opção da fila de jobs desconhecida: " + key);
+            }
+        }
+    }
+    
+    void validate() const {
+        if (port < 1 || port > 65535) throw runtime_error("Porta inválida: " + to_string(port));
+        if (threads == 0) throw runtime_error("threads deve ser pelo menos 1");
+        if (listeners == 0) throw runtime_error("listeners deve ser pelo menos 1");
+        if (maxBodyBytes == 0) throw runtime_error("max_body_bytes deve ser maior que zero");
+        const auto& routes = knownRoutes();
+        for (const auto& [route, limit] : routeLimits) {
+            if (find(routes.begin(), routes.end(), route) == routes.end()) {
+                string valid;
+                for (const auto& known : routes) valid += (valid.empty() ? "" : ", ") + known;
+                throw runtime_error("Rota desconhecida em route_limits: " + route + " (rotas: " + valid + ")");
+            }
+            if (limit == 0) throw runtime_error("Limite zero para a rota " + route);
+        }
+        if (engine != "auto" && engine != "torch" && engine != "onnx") {
+            throw runtime_error("Motor de inferência inválido: " + engine);
+        }
+        if (!artifactCache.spillDir.empty() && artifactCache.maxSpillBytes == 0) {
+            throw runtime_error("artifact_cache.max_spill_bytes deve ser maior que zero com spill_dir");
+        }
+        if (jobs.maxPending == 0 || jobs.ttl.count() <= 0 || jobs.maxRetainedBytes == 0) {
+            throw runtime_error("jobs.max_pending, jobs.ttl e jobs.max_retained_bytes devem ser maiores que zero");
+        }
+        if (!adminToken.empty() && adminToken.size() < 16) {
+            throw runtime_error("admin_token deve ter pelo menos 16 caracteres");
+        }
+        if (nlpCache.maxBytes == 0 || nlpCache.ttl.count() <= 0) {
+            throw runtime_error("nlp_cache.max_bytes e nlp_cache.ttl devem ser maiores que zero");
+        }
+        if (inference.maxBatch == 0 || inference.workers == 0 || inference.intraOpThreads < 1) {
+            throw runtime_error("Parâmetros de inferência inválidos");
+        }
+    }
+};
+
+// Restringe a thread atual (e as que ela criar depois) às CPUs da lista
+inline bool pinCurrentThread(const vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,501 @@
+// telemetry.h - Métricas (histogramas, contadores) e rastreamento de requisições
+#pragma once
+
+#include "common.h"
+
+// Índice pequeno e estável da thread atual, usado para escolher o shard das
+// métricas; threads além de `limit` compartilham shards (os contadores são
+// atômicos, então o compartilhamento só custa disputa, não exatidão)
+inline size_t telemetryThreadIndex(size_t limit) {
+    static atomic<size_t> nextIndex{0};
+    thread_local size_t index = nextIndex.fetch_add(1, memory_order_relaxed);
+    return index % limit;
+}
+
+// Histograma de latência log-linear (estilo HDR): 8 sub-faixas lineares por
+// potência de dois, de 1 ns a ~37 min, com erro relativo máximo de 12,5%,
+// e um último bucket para o que passar disso.
+// Cada thread grava no seu próprio shard, alocado no primeiro uso, com
+// incrementos atômicos relaxados sem disputa; a leitura soma os shards.
+class LatencyHistogram {
+public:
+    static constexpr size_t SUB_BUCKETS = 8;
+    static constexpr size_t MAX_EXPONENT = 41;
+    // 0..7 ns um a um, 8 sub-faixas para cada expoente de 3 a MAX_EXPONENT - 1
+    // e o bucket de estouro
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - 2) * SUB_BUCKETS + 1;
+    static constexpr size_t MAX_SHARDS = 64;
+    
+    struct Snapshot {
+        array<uint64_t, BUCKETS> counts{};
+        uint64_t count = 0;
+        uint64_t sumNanos = 0;
+    };
+    
+    // Maior valor (inclusive, em ns) que cai no bucket
+    static uint64_t bucketUpperBound(size_t bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        if (bucket == BUCKETS - 1) return UINT64_MAX;
+        size_t exponent = bucket / SUB_BUCKETS + 2;
+        uint64_t width = uint64_t(1) << (exponent - 3);
+        return (SUB_BUCKETS + bucket % SUB_BUCKETS) * width + width - 1;
+    }
+    
+private:
+    struct alignas(64) Shard {
+        array<atomic<uint64_t>, BUCKETS> counts{};
+        atomic<uint64_t> sumNanos{0};
+    };
+    
+    array<atomic<Shard*>, MAX_SHARDS> shards{};
+    
+    static size_t bucketFor(uint64_t nanos) {
+        if (nanos < SUB_BUCKETS) return static_cast<size_t>(nanos);
+        size_t exponent = min<size_t>(63 - static_cast<size_t>(__builtin_clzll(nanos)), MAX_EXPONENT);
+        if (exponent == MAX_EXPONENT) return BUCKETS - 1;
+        size_t sub = static_cast<size_t>(nanos >> (exponent - 3)) & (SUB_BUCKETS - 1);
+        return (exponent - 2) * SUB_BUCKETS + sub;
+    }
+    
+    Shard& localShard() {
+        auto& slot = shards[telemetryThreadIndex(MAX_SHARDS)];
+        Shard* shard = slot.load(memory_order_acquire);
+        if (shard) return *shard;
+        
+        auto created = make_unique<Shard>();
+        if (slot.compare_exchange_strong(shard, created.get(), memory_order_acq_rel)) {
+            return *created.release();
+        }
+        return *shard;
+    }
+    
+public:
+    LatencyHistogram() = default;
+    
+    ~LatencyHistogram() {
+        for (auto& slot : shards) delete slot.load();
+    }
+    
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+    
+    void record(uint64_t nanos) {
+        Shard& shard = localShard();
+        shard.counts[bucketFor(nanos)].fetch_add(1, memory_order_relaxed);
+        shard.sumNanos.fetch_add(nanos, memory_order_relaxed);
+    }
+    
+    void record(chrono::steady_clock::duration elapsed) {
+        record(static_cast<uint64_t>(max<int64_t>(0, chrono::duration_cast<chrono::nanoseconds>(elapsed).count())));
+    }
+    
+    Snapshot snapshot() const {
+        Snapshot result;
+        for (const auto& slot : shards) {
+            const Shard* shard = slot.load(memory_order_acquire);
+            if (!shard) continue;
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                uint64_t count = shard->counts[i].load(memory_order_relaxed);
+                result.counts[i] += count;
+                result.count += count;
+            }
+            result.sumNanos += shard->sumNanos.load(memory_order_relaxed);
+        }
+        return result;
+    }
+};
+
+// Contador monotônico dividido em shards por thread, para que incrementos de
+// threads diferentes não disputem a mesma linha de cache
+class TelemetryCounter {
+private:
+    static constexpr size_t SHARDS = 16;
+    
+    struct alignas(64) Shard {
+        atomic<uint64_t> value{0};
+    };
+    
+    array<Shard, SHARDS> shards;
+    
+public:
+    void add(uint64_t amount = 1) {
+        shards[telemetryThreadIndex(SHARDS)].value.fetch_add(amount, memory_order_relaxed);
+    }
+    
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards) total += shard.value.load(memory_order_relaxed);
+        return total;
+    }
+};
+
+// Registro global das métricas, exportadas em /metrics no formato texto do
+// Prometheus. O registro usa um mutex, mas acontece uma vez por métrica: o
+// código instrumentado guarda a referência (em geral numa static local) e
+// depois só grava no shard da própria thread.
+class Telemetry {
+private:
+    struct HistogramEntry {
+        string name;
+        string help;
+        string labels;
+        LatencyHistogram histogram;
+    };
+    
+    struct CounterEntry {
+        string name;
+        string help;
+        string labels;
+        TelemetryCounter counter;
+    };
+    
+    struct GaugeEntry {
+        string name;
+        string help;
+        function<double()> read;
+    };
+    
+    // Limites (em segundos) exportados como buckets do Prometheus; os
+    // buckets finos do histograma são agregados neles
+    static constexpr double EXPORT_BOUNDS[] = {
+        0.00001, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+        0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+    };
+    
+    mutable mutex mtx;
+    deque<HistogramEntry> histograms;
+    deque<CounterEntry> counters;
+    deque<GaugeEntry> gauges;
+    
+    static void writeHelp(string& out, const string& name, const string& help, const char* type) {
+        out += "# HELP " + name + " " + help + "\n";
+        out += "# TYPE " + name + " " + type + "\n";
+    }
+    
+    static string withLabels(const string& labels, const string& extra = "") {
+        string all = labels;
+        if (!extra.empty()) all += (all.empty() ? "" : ",") + extra;
+        return all.empty() ? "" : "{" + all + "}";
+    }
+    
+    Telemetry() = default;
+    
+public:
+    static Telemetry& get() {
+        static Telemetry instance;
+        return instance;
+    }
+    
+    // `labels` no formato do Prometheus sem chaves, ex.: route="/api/process"
+    LatencyHistogram& histogram(const string& name, const string& help, const string& labels = "") {
+        lock_guard<mutex> lock(mtx);
+        for (auto& entry : histograms) {
+            if (entry.name == name && entry.labels == labels) return entry.histogram;
+        }
+        histograms.emplace_back();
+        histograms.back().name = name;
+        histograms.back().help = help;
+        histograms.back().labels = labels;
+        return histograms.back().histogram;
+    }
+    
+    TelemetryCounter& counter(const string& name, const string& help, const string& labels = "") {
+        lock_guard<mutex> lock(mtx);
+        for (auto& entry : counters) {
+            if (entry.name == name && entry.labels == labels) return entry.counter;
+        }
+        counters.emplace_back();
+        counters.back().name = name;
+        counters.back().help = help;
+        counters.back().labels = labels;
+        return counters.back().counter;
+    }
+    
+    // Valor lido na hora da coleta (tamanho de fila, etc.)
+    void gauge(const string& name, const string& help, function<double()> read) {
+        lock_guard<mutex> lock(mtx);
+        gauges.push_back({name, help, move(read)});
+    }
+    
+    string renderPrometheus() const {
+        lock_guard<mutex> lock(mtx);
+        string out;
+        out.reserve(16 * 1024);
+        string lastName;
+        
+        // Cada família precisa sair contígua, mas o registro é preguiçoso e
+        // pode intercalar nomes
+        vector<const HistogramEntry*> sortedHistograms;
+        for (const auto& entry : histograms) sortedHistograms.push_back(&entry);
+        stable_sort(sortedHistograms.begin(), sortedHistograms.end(),
+                    [](const HistogramEntry* a, const HistogramEntry* b) { return a->name < b->name; });
+        vector<const CounterEntry*> sortedCounters;
+        for (const auto& entry : counters) sortedCounters.push_back(&entry);
+        stable_sort(sortedCounters.begin(), sortedCounters.end(),
+                    [](const CounterEntry* a, const CounterEntry* b) { return a->name < b->name; });
+        
+        for (const auto* histogramEntry : sortedHistograms) {
+            const auto& entry = *histogramEntry;
+            if (entry.name != lastName) writeHelp(out, entry.name, entry.help, "histogram");
+            lastName = entry.name;
+            
+            auto snapshot = entry.histogram.snapshot();
+            uint64_t cumulative = 0;
+            size_t bucket = 0;
+            for (double bound : EXPORT_BOUNDS) {
+                uint64_t limit = static_cast<uint64_t>(bound * 1e9);
+                while (bucket < LatencyHistogram::BUCKETS && LatencyHistogram::bucketUpperBound(bucket) <= limit) {
+                    cumulative += snapshot.counts[bucket++];
+                }
+                ostringstream le;
+                le << bound;
+                out += entry.name + "_bucket" + withLabels(entry.labels, "le=\"" + le.str() + "\"") + " " +
+                       to_string(cumulative) + "\n";
+            }
+            out += entry.name + "_bucket" + withLabels(entry.labels, "le=\"+Inf\"") + " " + to_string(snapshot.count) + "\n";
+            ostringstream sum;
+            sum << static_cast<double>(snapshot.sumNanos) / 1e9;
+            out += entry.name + "_sum" + withLabels(entry.labels) + " " + sum.str() + "\n";
+            out += entry.name + "_count" + withLabels(entry.labels) + " " + to_string(snapshot.count) + "\n";
+        }
+        
+        lastName.clear();
+        for (const auto* counterEntry : sortedCounters) {
+            const auto& entry = *counterEntry;
+            if (entry.name != lastName) writeHelp(out, entry.name, entry.help, "counter");
+            lastName = entry.name;
+            out += entry.name + withLabels(entry.labels) + " " + to_string(entry.counter.value()) + "\n";
+        }
+        
+        for (const auto& entry : gauges) {
+            writeHelp(out, entry.name, entry.help, "gauge");
+            ostringstream value;
+            value << entry.read();
+            out += entry.name + " " + value.str() + "\n";
+        }
+        return out;
+    }
+};
+
+// Rastreamento por requisição: spans (nome, início, duração) gravados num
+// buffer circular por thread e exportados no formato trace_event do Chrome,
+// que o Perfetto abre direto. Só uma fração das requisições é amostrada; nas
+// demais cada span custa uma leitura de thread_local. Gravar não aloca: o
+// nome é um literal (ou internado no registro) e o slot já existe no buffer.
+class Tracer {
+public:
+    static constexpr size_t RING_CAPACITY = 2048;
+    
+private:
+    // Slot com seqlock: o escritor (a própria thread) deixa a sequência ímpar
+    // durante a escrita, e o leitor descarta o que mudou enquanto lia
+    struct Slot {
+        atomic<uint32_t> sequence{0};
+        atomic<const char*> name{nullptr};
+        atomic<uint64_t> trace{0};
+        atomic<uint64_t> start{0};
+        atomic<uint64_t> duration{0};
+    };
+    
+    struct Ring {
+        array<Slot, RING_CAPACITY> slots;
+        atomic<uint64_t> next{0};
+        uint32_t threadId = 0;
+    };
+    
+    struct Event {
+        const char* name;
+        uint64_t trace;
+        uint64_t start;
+        uint64_t duration;
+        uint32_t threadId;
+    };
+    
+    mutable mutex mtx;
+    vector<shared_ptr<Ring>> rings;  // continuam legíveis depois que a thread termina
+    deque<string> internedNames;
+    atomic<uint64_t> sampleEvery{100};
+    atomic<uint64_t> nextTraceId{0};
+    
+    Tracer() = default;
+    
+    Ring& localRing() {
+        thread_local Ring* ring = nullptr;
+        if (!ring) {
+            auto created = make_shared<Ring>();
+            lock_guard<mutex> lock(mtx);
+            created->threadId = static_cast<uint32_t>(rings.size() + 1);
+            rings.push_back(created);
+            ring = created.get();
+        }
+        return *ring;
+    }
+    
+public:
+    static Tracer& get() {
+        static Tracer instance;
+        return instance;
+    }
+    
+    // Nanossegundos desde o início do processo
+    static uint64_t now() {
+        return static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - processStart).count());
+    }
+    
+    // Trace da requisição em andamento nesta thread (0 = não amostrada)
+    static uint64_t& currentTrace() {
+        thread_local uint64_t trace = 0;
+        return trace;
+    }
+    
+    // Amostra 1 a cada `every` requisições (0 desliga o rastreamento)
+    void setSampleEvery(uint64_t every) {
+        sampleEvery.store(every, memory_order_relaxed);
+    }
+    
+    // Novo id de trace, ou 0 se a requisição não for amostrada
+    uint64_t sample() {
+        uint64_t every = sampleEvery.load(memory_order_relaxed);
+        if (every == 0) return 0;
+        thread_local uint64_t counter = 0;
+        if (counter++ % every != 0) return 0;
+        return nextTraceId.fetch_add(1, memory_order_relaxed) + 1;
+    }
+    
+    // Cópia estável de um nome montado em tempo de execução (ex.: a rota),
+    // para ser usada como nome de span; chamar na configuração, não por span
+    const char* intern(const string& name) {
+        lock_guard<mutex> lock(mtx);
+        for (const auto& existing : internedNames) {
+            if (existing == name) return existing.c_str();
+        }
+        internedNames.push_back(name);
+        return internedNames.back().c_str();
+    }
+    
+    void record(const char* name, uint64_t trace, uint64_t start, uint64_t end) {
+        Ring& ring = localRing();
+        uint64_t index = ring.next.load(memory_order_relaxed);
+        Slot& slot = ring.slots[index % RING_CAPACITY];
+        
+        uint32_t sequence = slot.sequence.load(memory_order_relaxed);
+        slot.sequence.store(sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.name.store(name, memory_order_relaxed);
+        slot.trace.store(trace, memory_order_relaxed);
+        slot.start.store(start, memory_order_relaxed);
+        slot.duration.store(end - start, memory_order_relaxed);
+        slot.sequence.store(sequence + 2, memory_order_release);
+        ring.next.store(index + 1, memory_order_release);
+    }
+    
+    // Spans ainda nos buffers, no formato trace_event do Chrome; `trace`
+    // filtra um trace (0 = todos) e `limit` mantém só os mais recentes
+    json renderChromeTrace(uint64_t trace = 0, size_t limit = 10000) const {
+        vector<shared_ptr<Ring>> snapshot;
+        {
+            lock_guard<mutex> lock(mtx);
+            snapshot = rings;
+        }
+        
+        vector<Event> events;
+        for (const auto& ring : snapshot) {
+            for (const Slot& slot : ring->slots) {
+                uint32_t before = slot.sequence.load(memory_order_acquire);
+                if (before == 0 || (before & 1) != 0) continue;
+                Event event{slot.name.load(memory_order_relaxed), slot.trace.load(memory_order_relaxed),
+                            slot.start.load(memory_order_relaxed), slot.duration.load(memory_order_relaxed),
+                            ring->threadId};
+                atomic_thread_fence(memory_order_acquire);
+                if (slot.sequence.load(memory_order_relaxed) != before) continue;
+                if (trace != 0 && event.trace != trace) continue;
+                events.push_back(event);
+            }
+        }
+        
+        sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.start < b.start; });
+        if (events.size() > limit) events.erase(events.begin(), events.end() - static_cast<ptrdiff_t>(limit));
+        
+        json traceEvents = json::array();
+        for (const auto& event : events) {
+            traceEvents.push_back({
+                {"name", event.name},
+                {"cat", "paulo"},
+                {"ph", "X"},
+                {"ts", static_cast<double>(event.start) / 1000.0},
+                {"dur", static_cast<double>(event.duration) / 1000.0},
+                {"pid", 1},
+                {"tid", event.threadId},
+                {"args", {{"trace_id", event.trace}}}
+            });
+        }
+        return {{"traceEvents", move(traceEvents)}, {"displayTimeUnit", "ms"}};
+    }
+};
+
+// Define o trace da thread atual durante o escopo: um id novo (amostrado) no
+// início de uma requisição, ou um id recebido de outra thread para continuar o
+// mesmo trace num job ou worker
+class TraceContext {
+private:
+    uint64_t previous;
+    
+public:
+    explicit TraceContext(uint64_t trace) : previous(Tracer::currentTrace()) {
+        Tracer::currentTrace() = trace;
+    }
+    
+    ~TraceContext() {
+        Tracer::currentTrace() = previous;
+    }
+    
+    TraceContext(const TraceContext&) = delete;
+    TraceContext& operator=(const TraceContext&) = delete;
+};
+
+// Span do trace atual; não faz nada se a requisição não foi amostrada.
+// `name` precisa viver até a exportação (literal ou Tracer::intern).
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t trace;
+    uint64_t start = 0;
+    
+public:
+    explicit TraceSpan(const char* name) : name(name), trace(Tracer::currentTrace()) {
+        if (trace != 0) start = Tracer::now();
+    }
+    
+    ~TraceSpan() {
+        if (trace != 0) Tracer::get().record(name, trace, start, Tracer::now());
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Histograma da etapa `stage` do pipeline (tokenize, sentiment, etc.)
+inline LatencyHistogram& stageHistogram(const string& stage) {
+    return Telemetry::get().histogram("paulo_stage_duration_seconds", "Duração das etapas do processamento",
+                                      "stage=\"" + stage + "\"");
+}
+
+// Mede o tempo entre a construção e a destruição e grava no histograma e,
+// se a requisição foi amostrada, como span `span` do trace
+class StageTimer {
+private:
+    LatencyHistogram& histogram;
+    TraceSpan traceSpan;
+    chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    
+public:
+    StageTimer(LatencyHistogram& histogram, const char* span) : histogram(histogram), traceSpan(span) {}
+    
+    ~StageTimer() {
+        histogram.record(chrono::steady_clock::now() - started);
+    }
+    
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+};
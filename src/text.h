@@ -0,0 +1,1042 @@
+// text.h - Tokenização, léxico de sentimentos, entidades e intenções
+#pragma once
+
+#include "common.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <unicode/unistr.h>  // ICU para processamento de texto
+#include <unicode/uchar.h>
+#include <unicode/utf8.h>
+
+// Bytes ASCII que fazem parte de palavras: [A-Za-z0-9_'-]
+constexpr array<bool, 128> buildAsciiWordTable() {
+    array<bool, 128> table{};
+    for (int c = 'a'; c <= 'z'; ++c) table[c] = true;
+    for (int c = 'A'; c <= 'Z'; ++c) table[c] = true;
+    for (int c = '0'; c <= '9'; ++c) table[c] = true;
+    table['_'] = table['\''] = table['-'] = true;
+    return table;
+}
+
+// Tokenizador UTF-8 sem regex e sem alocação por token: devolve fatias da
+// própria entrada. Caracteres de palavra são os do antigo [\w'-] no ASCII
+// (via tabela) e, fora do ASCII, letras, dígitos e marcas combinantes segundo
+// o ICU, de modo que "ótimo" e "péssimo" saem inteiros. Trechos ASCII longos
+// são verificados 16 bytes por vez com SSE2 quando disponível.
+class Utf8Tokenizer {
+private:
+    static constexpr array<bool, 128> ASCII_WORD = buildAsciiWordTable();
+    
+    static bool isWordCodePoint(UChar32 c) {
+        if (c < 0x80) return c >= 0 && ASCII_WORD[c];
+        if (u_isalnum(c)) return true;
+        int8_t type = u_charType(c);
+        return type == U_NON_SPACING_MARK || type == U_COMBINING_SPACING_MARK || type == U_ENCLOSING_MARK;
+    }
+    
+    // Quantos bytes a partir de `p` são caracteres de palavra ASCII, olhando
+    // blocos inteiros de 16; o restante fica para o laço escalar
+    static size_t asciiWordRun(const char* p, size_t n) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i caseBit = _mm_set1_epi8(0x20);
+        while (i + 16 <= n) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            // Bytes >= 0x80 são negativos na comparação com sinal e nunca passam
+            __m128i lower = _mm_or_si128(v, caseBit);
+            __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                          _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+            __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                          _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+            __m128i punct = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')),
+                                         _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')),
+                                                      _mm_cmpeq_epi8(v, _mm_set1_epi8('-'))));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(alpha, _mm_or_si128(digit, punct))));
+            if (mask != 0xffff) return i + static_cast<size_t>(__builtin_ctz(~mask));
+            i += 16;
+        }
+#else
+        (void)p;
+        (void)n;
+#endif
+        return i;
+    }
+    
+public:
+    // `tokens` é qualquer vetor de string_view (std:: ou pmr::)
+    template<typename Tokens>
+    static void tokenize(string_view text, Tokens& tokens) {
+        const char* s = text.data();
+        const int32_t n = static_cast<int32_t>(min<size_t>(text.size(), INT32_MAX));
+        int32_t i = 0;
+        
+        while (i < n) {
+            // Procura o início do próximo token
+            int32_t start = i;
+            UChar32 c;
+            U8_NEXT(s, i, n, c);
+            if (!isWordCodePoint(c)) continue;
+            
+            // Consome o token
+            while (i < n) {
+                i += static_cast<int32_t>(asciiWordRun(s + i, static_cast<size_t>(n - i)));
+                if (i >= n) break;
+                
+                unsigned char b = static_cast<unsigned char>(s[i]);
+                if (b < 0x80) {
+                    if (!ASCII_WORD[b]) break;
+                    ++i;
+                    continue;
+                }
+                
+                int32_t next = i;
+                U8_NEXT(s, next, n, c);
+                if (!isWordCodePoint(c)) break;
+                i = next;
+            }
+            tokens.emplace_back(s + start, static_cast<size_t>(i - start));
+        }
+    }
+    
+    static vector<string_view> tokenize(string_view text) {
+        vector<string_view> tokens;
+        tokens.reserve(text.size() / 6 + 1);
+        tokenize(text, tokens);
+        return tokens;
+    }
+    
+    // Mesmo resultado, com o vetor alocado em `memory` (ex.: a arena da
+    // requisição)
+    static pmr::vector<string_view> tokenize(string_view text, pmr::memory_resource* memory) {
+        pmr::vector<string_view> tokens(memory);
+        tokens.reserve(text.size() / 6 + 1);
+        tokenize(text, tokens);
+        return tokens;
+    }
+};
+
+// Fim de frase no trecho entre dois tokens: quebra de linha ou '.', '!' ou
+// '?' seguido de espaço. Pontos sem espaço depois ("3.5", "a.b@c.com") não
+// contam.
+inline bool isSentenceBreak(string_view gap) {
+    bool terminator = false;
+    for (char c : gap) {
+        if (c == '\n') return true;
+        if (c == '.' || c == '!' || c == '?') {
+            terminator = true;
+        } else if (terminator && isspace(static_cast<unsigned char>(c))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Divide `text` em segmentos [início, fim) de pelo menos `targetSize` bytes
+// (o último pode ser menor) que terminam logo depois de um fim de frase. Os
+// cortes caem sempre depois de um espaço ASCII, nunca no meio de um caractere
+// UTF-8 ou de um token; um trecho sem fim de frase fica num segmento só.
+inline vector<pair<size_t, size_t>> splitAtSentences(string_view text, size_t targetSize) {
+    vector<pair<size_t, size_t>> segments;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.size();
+        for (size_t i = begin + max<size_t>(targetSize, 1); i < text.size(); ++i) {
+            char c = text[i];
+            char previous = text[i - 1];
+            bool afterTerminator = previous == '.' || previous == '!' || previous == '?';
+            if (c == '\n' || (afterTerminator && isspace(static_cast<unsigned char>(c)))) {
+                end = i + 1;
+                break;
+            }
+        }
+        segments.emplace_back(begin, end);
+        begin = end;
+    }
+    return segments;
+}
+
+// Case folding (simples, código a código) de `text` para `out`; retorna o
+// tamanho escrito ou 0 se não couber
+inline size_t foldCaseUtf8(string_view text, char* out, size_t capacity) {
+    const char* s = text.data();
+    const int32_t n = static_cast<int32_t>(min<size_t>(text.size(), INT32_MAX));
+    int32_t i = 0;
+    int32_t length = 0;
+    
+    while (i < n) {
+        unsigned char b = static_cast<unsigned char>(s[i]);
+        if (b < 0x80) {
+            if (static_cast<size_t>(length) >= capacity) return 0;
+            out[length++] = static_cast<char>(b >= 'A' && b <= 'Z' ? b + 32 : b);
+            ++i;
+            continue;
+        }
+        
+        UChar32 c;
+        U8_NEXT(s, i, n, c);
+        if (c < 0) return 0;
+        c = u_foldCase(c, U_FOLD_CASE_DEFAULT);
+        if (static_cast<size_t>(length) + U8_LENGTH(c) > capacity) return 0;
+        UBool error = false;
+        U8_APPEND(reinterpret_cast<uint8_t*>(out), length, static_cast<int32_t>(capacity), c, error);
+        if (error) return 0;
+    }
+    return static_cast<size_t>(length);
+}
+
+
+// Papel de um termo do léxico de sentimentos
+enum class LexiconEntryKind : uint8_t {
+    Polarity,     // soma `weight` ao escore
+    Negation,     // inverte o próximo termo de polaridade
+    Intensifier   // multiplica o próximo termo de polaridade por `weight`
+};
+
+struct LexiconSeed {
+    string_view term;
+    float weight;
+    LexiconEntryKind kind;
+};
+
+// Léxico padrão, usado quando nenhum arquivo é carregado
+constexpr LexiconSeed DEFAULT_LEXICON[] = {
+    {"bom", 0.5f, LexiconEntryKind::Polarity},
+    {"ótimo", 0.5f, LexiconEntryKind::Polarity},
+    {"excelente", 0.5f, LexiconEntryKind::Polarity},
+    {"maravilhoso", 0.5f, LexiconEntryKind::Polarity},
+    {"ruim", -0.5f, LexiconEntryKind::Polarity},
+    {"péssimo", -0.5f, LexiconEntryKind::Polarity},
+    {"horrível", -0.5f, LexiconEntryKind::Polarity},
+    {"terrível", -0.5f, LexiconEntryKind::Polarity},
+};
+
+// Léxico de sentimentos compilado numa tabela hash de endereçamento aberto
+// (sondagem linear, ocupação máxima de 50%). As chaves ficam todas num único
+// buffer, com case folding do ICU aplicado; a consulta faz o folding do token
+// num buffer na pilha, então não aloca memória.
+class SentimentLexicon {
+private:
+    struct Slot {
+        uint32_t offset = 0;
+        uint32_t length = 0;  // 0 = vazio
+        float weight = 0.0f;
+        LexiconEntryKind kind = LexiconEntryKind::Polarity;
+    };
+    
+    // Termos maiores que isso não cabem no buffer de folding e são ignorados
+    static constexpr size_t MAX_TERM_BYTES = 96;
+    // Quantos tokens um modificador (negação/intensificador) continua valendo
+    static constexpr int MODIFIER_WINDOW = 3;
+    
+    string keys;
+    vector<Slot> slots;
+    size_t mask = 0;
+    size_t count = 0;
+    
+    static uint64_t hashKey(string_view key) {
+        // FNV-1a
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : key) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+    
+    const Slot* findFolded(string_view folded) const {
+        if (slots.empty()) return nullptr;
+        
+        for (size_t i = hashKey(folded) & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.length == 0) return nullptr;
+            if (slot.length == folded.size() &&
+                memcmp(keys.data() + slot.offset, folded.data(), folded.size()) == 0) {
+                return &slot;
+            }
+        }
+    }
+    
+    void rehash(size_t capacity) {
+        vector<Slot> old = move(slots);
+        slots.assign(capacity, Slot{});
+        mask = capacity - 1;
+        for (const Slot& slot : old) {
+            if (slot.length == 0) continue;
+            size_t i = hashKey(string_view(keys.data() + slot.offset, slot.length)) & mask;
+            while (slots[i].length != 0) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+    
+public:
+    SentimentLexicon() {
+        for (const auto& seed : DEFAULT_LEXICON) {
+            add(seed.term, seed.weight, seed.kind);
+        }
+    }
+    
+    // Adiciona ou substitui um termo
+    void add(string_view term, float weight, LexiconEntryKind kind) {
+        char folded[MAX_TERM_BYTES];
+        size_t length = foldCaseUtf8(term, folded, sizeof(folded));
+        if (length == 0) return;
+        string_view key(folded, length);
+        
+        if (Slot* existing = const_cast<Slot*>(findFolded(key))) {
+            existing->weight = weight;
+            existing->kind = kind;
+            return;
+        }
+        
+        if ((count + 1) * 2 > slots.size()) {
+            rehash(max<size_t>(16, slots.size() * 2));
+        }
+        
+        Slot slot;
+        slot.offset = static_cast<uint32_t>(keys.size());
+        slot.length = static_cast<uint32_t>(length);
+        slot.weight = weight;
+        slot.kind = kind;
+        keys.append(folded, length);
+        
+        size_t i = hashKey(key) & mask;
+        while (slots[i].length != 0) i = (i + 1) & mask;
+        slots[i] = slot;
+        ++count;
+    }
+    
+    // Carrega termos de um arquivo, um por linha: "termo peso [tipo]", com
+    // tipo em {polaridade, negacao, intensificador} (padrão: polaridade).
+    // Linhas vazias e iniciadas por '#' são ignoradas.
+    void loadFile(const string& path) {
+        ifstream file(path);
+        if (!file) {
+            throw runtime_error("Não foi possível abrir o léxico: " + path);
+        }
+        
+        string line;
+        size_t lineNumber = 0;
+        while (getline(file, line)) {
+            ++lineNumber;
+            if (line.empty() || line[0] == '#') continue;
+            
+            istringstream fields(line);
+            string term, kindName;
+            float weight = 0.0f;
+            if (!(fields >> term >> weight)) {
+                throw runtime_error("Léxico inválido em " + path + ":" + to_string(lineNumber));
+            }
+            fields >> kindName;
+            
+            LexiconEntryKind kind = LexiconEntryKind::Polarity;
+            if (kindName == "negacao") {
+                kind = LexiconEntryKind::Negation;
+            } else if (kindName == "intensificador") {
+                kind = LexiconEntryKind::Intensifier;
+            } else if (!kindName.empty() && kindName != "polaridade") {
+                throw runtime_error("Tipo de termo desconhecido em " + path + ":" + to_string(lineNumber));
+            }
+            add(term, weight, kind);
+        }
+    }
+    
+    size_t size() const {
+        return count;
+    }
+    
+    // Consulta O(1) sem alocação
+    const Slot* find(string_view token) const {
+        char folded[MAX_TERM_BYTES];
+        size_t length = foldCaseUtf8(token, folded, sizeof(folded));
+        if (length == 0) return nullptr;
+        return findFolded(string_view(folded, length));
+    }
+    
+    // Soma dos pesos dos termos, aplicando negações e intensificadores aos
+    // termos de polaridade que aparecem logo depois deles, na mesma frase.
+    // Os tokens precisam ser fatias em ordem de um mesmo texto (como os do
+    // Utf8Tokenizer), porque o fim de frase é procurado entre eles.
+    template<typename Tokens>
+    double rawScore(const Tokens& tokens) const {
+        double score = 0.0;
+        bool negate = false;
+        double multiplier = 1.0;
+        int window = 0;
+        
+        for (size_t t = 0; t < tokens.size(); ++t) {
+            const string_view& token = tokens[t];
+            if (window > 0) {
+                const char* previousEnd = tokens[t - 1].data() + tokens[t - 1].size();
+                if (isSentenceBreak(string_view(previousEnd, static_cast<size_t>(token.data() - previousEnd)))) {
+                    negate = false;
+                    multiplier = 1.0;
+                    window = 0;
+                }
+            }
+            
+            const Slot* slot = find(token);
+            if (!slot) {
+                if (window > 0 && --window == 0) {
+                    negate = false;
+                    multiplier = 1.0;
+                }
+                continue;
+            }
+            
+            switch (slot->kind) {
+                case LexiconEntryKind::Negation:
+                    negate = !negate;
+                    window = MODIFIER_WINDOW;
+                    break;
+                case LexiconEntryKind::Intensifier:
+                    multiplier *= slot->weight;
+                    window = MODIFIER_WINDOW;
+                    break;
+                case LexiconEntryKind::Polarity:
+                    score += (negate ? -1.0 : 1.0) * multiplier * slot->weight;
+                    negate = false;
+                    multiplier = 1.0;
+                    window = 0;
+                    break;
+            }
+        }
+        return score;
+    }
+};
+
+// Autômato de Aho-Corasick sobre bytes: encontra todas as ocorrências de um
+// conjunto de padrões numa única passada, em tempo linear no tamanho do texto
+// (mais o número de ocorrências), independente de quantos padrões existam.
+// As transições de cada nó ficam num vetor ordenado para manter o autômato
+// compacto mesmo com dicionários grandes.
+class AhoCorasick {
+private:
+    static constexpr uint32_t NO_PATTERN = UINT32_MAX;
+    
+    struct Node {
+        vector<pair<uint8_t, uint32_t>> edges;  // ordenado por byte
+        uint32_t fail = 0;
+        uint32_t output = 0;       // nó mais próximo na cadeia de falhas com padrão (0 = nenhum)
+        uint32_t pattern = NO_PATTERN;
+        uint32_t length = 0;       // tamanho do padrão em bytes
+    };
+    
+    vector<Node> nodes{1};
+    bool built = false;
+    
+    uint32_t edge(uint32_t node, uint8_t byte) const {
+        const auto& edges = nodes[node].edges;
+        auto it = lower_bound(edges.begin(), edges.end(), byte,
+                              [](const pair<uint8_t, uint32_t>& e, uint8_t b) { return e.first < b; });
+        return it != edges.end() && it->first == byte ? it->second : 0;
+    }
+    
+public:
+    // Adiciona um padrão; `id` é devolvido nas ocorrências
+    void add(string_view pattern, uint32_t id) {
+        if (pattern.empty()) return;
+        
+        uint32_t node = 0;
+        for (unsigned char byte : pattern) {
+            uint32_t next = edge(node, byte);
+            if (next == 0) {
+                next = static_cast<uint32_t>(nodes.size());
+                auto& edges = nodes[node].edges;
+                auto it = lower_bound(edges.begin(), edges.end(), byte,
+                                      [](const pair<uint8_t, uint32_t>& e, uint8_t b) { return e.first < b; });
+                edges.insert(it, {byte, next});
+                nodes.emplace_back();
+            }
+            node = next;
+        }
+        nodes[node].pattern = id;
+        nodes[node].length = static_cast<uint32_t>(pattern.size());
+        built = false;
+    }
+    
+    // Calcula os links de falha (BFS); deve ser chamado depois dos add()
+    void build() {
+        deque<uint32_t> queue;
+        for (const auto& [byte, child] : nodes[0].edges) {
+            nodes[child].fail = 0;
+            queue.push_back(child);
+        }
+        
+        while (!queue.empty()) {
+            uint32_t node = queue.front();
+            queue.pop_front();
+            
+            for (const auto& [byte, child] : nodes[node].edges) {
+                uint32_t fail = nodes[node].fail;
+                while (fail != 0 && edge(fail, byte) == 0) fail = nodes[fail].fail;
+                uint32_t target = edge(fail, byte);
+                nodes[child].fail = target != child ? target : 0;
+                
+                uint32_t failNode = nodes[child].fail;
+                nodes[child].output = nodes[failNode].pattern != NO_PATTERN ? failNode : nodes[failNode].output;
+                queue.push_back(child);
+            }
+        }
+        built = true;
+    }
+    
+    bool empty() const {
+        return nodes.size() == 1;
+    }
+    
+    // Avança o autômato um byte
+    uint32_t step(uint32_t state, uint8_t byte) const {
+        while (true) {
+            uint32_t next = edge(state, byte);
+            if (next != 0 || state == 0) return next;
+            state = nodes[state].fail;
+        }
+    }
+    
+    // Chama fn(id, tamanho) para cada padrão que termina no estado atual
+    template<typename F>
+    void forEachMatch(uint32_t state, F&& fn) const {
+        if (nodes[state].pattern != NO_PATTERN) {
+            fn(nodes[state].pattern, nodes[state].length);
+        }
+        for (uint32_t node = nodes[state].output; node != 0; node = nodes[node].output) {
+            fn(nodes[node].pattern, nodes[node].length);
+        }
+    }
+};
+
+// Entidade encontrada: tipo e intervalo [start, end) em bytes no texto
+struct EntityMatch {
+    string_view type;
+    size_t start;
+    size_t end;
+};
+
+using EntityMatches = pmr::vector<EntityMatch>;
+
+// Extrator de entidades montado uma vez na inicialização. Todos os
+// reconhecedores (nomes próprios, e-mail, URL, telefone, CPF, CNPJ e o
+// dicionário de nomes conhecidos) rodam juntos numa única passada sobre o
+// texto, sem regex e sem retrocesso, em tempo linear no tamanho da entrada.
+class EntityExtractor {
+private:
+    static constexpr string_view PERSON = "PERSON";
+    static constexpr string_view EMAIL = "EMAIL";
+    static constexpr string_view URL = "URL";
+    static constexpr string_view PHONE = "PHONE";
+    static constexpr string_view CPF = "CPF";
+    static constexpr string_view CNPJ = "CNPJ";
+    
+    // Maior nome do dicionário, em code points; define o tamanho do histórico
+    // de posições usado para achar o início de uma ocorrência
+    static constexpr size_t MAX_GAZETTEER_CODE_POINTS = 64;
+    
+    AhoCorasick gazetteer;
+    vector<string> gazetteerTypes;
+    vector<pair<uint32_t, uint32_t>> gazetteerEntries;  // (tipo, code points) por padrão
+    
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+    
+    static bool isOneOf(char c, const char* set) {
+        return c != '\0' && strchr(set, c) != nullptr;
+    }
+    
+    static bool isAsciiAlpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+    
+    static bool isLetterOrDigit(UChar32 c) {
+        return c >= 0 && (c < 0x80 ? isDigit(static_cast<char>(c)) || isAsciiAlpha(static_cast<char>(c))
+                                   : static_cast<bool>(u_isalnum(c)));
+    }
+    
+    // Confere `token` contra uma máscara em que 'd' é um dígito e os demais
+    // caracteres são literais; copia os dígitos para `digits`
+    static bool matchDigitMask(string_view token, string_view mask, int* digits) {
+        if (token.size() != mask.size()) return false;
+        int count = 0;
+        for (size_t i = 0; i < mask.size(); ++i) {
+            if (mask[i] == 'd') {
+                if (!isDigit(token[i])) return false;
+                digits[count++] = token[i] - '0';
+            } else if (token[i] != mask[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    static bool allSameDigit(const int* digits, int count) {
+        for (int i = 1; i < count; ++i) {
+            if (digits[i] != digits[0]) return false;
+        }
+        return true;
+    }
+    
+    static bool validCpf(const int* d) {
+        if (allSameDigit(d, 11)) return false;
+        for (int check = 9; check <= 10; ++check) {
+            int sum = 0;
+            for (int i = 0; i < check; ++i) sum += d[i] * (check + 1 - i);
+            if ((sum * 10) % 11 % 10 != d[check]) return false;
+        }
+        return true;
+    }
+    
+    static bool validCnpj(const int* d) {
+        static constexpr int WEIGHTS[] = {6, 5, 4, 3, 2, 9, 8, 7, 6, 5, 4, 3, 2};
+        if (allSameDigit(d, 14)) return false;
+        for (int check = 12; check <= 13; ++check) {
+            int sum = 0;
+            const int* weights = WEIGHTS + (13 - check);
+            for (int i = 0; i < check; ++i) sum += d[i] * weights[i];
+            int rest = sum % 11;
+            if ((rest < 2 ? 0 : 11 - rest) != d[check]) return false;
+        }
+        return true;
+    }
+    
+    static bool isEmail(string_view token) {
+        size_t at = token.find('@');
+        if (at == 0 || at == string_view::npos || token.find('@', at + 1) != string_view::npos) return false;
+        
+        for (size_t i = 0; i < at; ++i) {
+            char c = token[i];
+            if (!isDigit(c) && !isAsciiAlpha(c) && !isOneOf(c, "._%+-")) return false;
+        }
+        
+        string_view domain = token.substr(at + 1);
+        size_t dot = domain.rfind('.');
+        if (dot == string_view::npos || dot == 0 || domain.size() - dot - 1 < 2) return false;
+        for (size_t i = 0; i < domain.size(); ++i) {
+            char c = domain[i];
+            if (i > dot ? !isAsciiAlpha(c) : !isDigit(c) && !isAsciiAlpha(c) && c != '.' && c != '-') return false;
+        }
+        return domain.find("..") == string_view::npos;
+    }
+    
+    static bool startsWithNoCase(string_view text, string_view prefix) {
+        if (text.size() < prefix.size()) return false;
+        for (size_t i = 0; i < prefix.size(); ++i) {
+            if ((text[i] | 0x20) != prefix[i]) return false;
+        }
+        return true;
+    }
+    
+    static bool isUrl(string_view token) {
+        for (string_view prefix : {string_view("https://"), string_view("http://"), string_view("www.")}) {
+            if (startsWithNoCase(token, prefix)) return token.size() > prefix.size() + 2;
+        }
+        return false;
+    }
+    
+    // Classifica um trecho sem espaços (já sem pontuação nas bordas)
+    static optional<string_view> classifyToken(string_view token) {
+        int digits[14];
+        if (matchDigitMask(token, "ddd.ddd.ddd-dd", digits) || matchDigitMask(token, "ddddddddddd", digits)) {
+            if (validCpf(digits)) return CPF;
+        }
+        if (matchDigitMask(token, "dd.ddd.ddd/dddd-dd", digits) || matchDigitMask(token, "dddddddddddddd", digits)) {
+            if (validCnpj(digits)) return CNPJ;
+        }
+        if (isUrl(token)) return URL;
+        if (isEmail(token)) return EMAIL;
+        return nullopt;
+    }
+    
+    // Telefone brasileiro a partir de `pos`: [+55 ][(dd) ]dddd[d][- ]dddd.
+    // Exige DDD ou separador para não confundir com números soltos.
+    // Retorna o fim da ocorrência ou 0.
+    static size_t matchPhone(string_view text, size_t pos) {
+        size_t i = pos;
+        auto digitRun = [&](size_t max) {
+            size_t start = i;
+            while (i < text.size() && i - start < max && isDigit(text[i])) ++i;
+            return i - start;
+        };
+        auto skipSpace = [&]() {
+            if (i < text.size() && text[i] == ' ') ++i;
+        };
+        
+        bool hasAreaCode = false;
+        if (text.compare(i, 3, "+55") == 0) {
+            i += 3;
+            skipSpace();
+        }
+        if (i < text.size() && text[i] == '(') {
+            ++i;
+            if (digitRun(2) != 2 || i >= text.size() || text[i] != ')') return 0;
+            ++i;
+            skipSpace();
+            hasAreaCode = true;
+        }
+        
+        size_t prefix = digitRun(5);
+        if (prefix < 4) return 0;
+        bool hasSeparator = i < text.size() && (text[i] == '-' || text[i] == ' ');
+        if (hasSeparator) ++i;
+        if (!hasAreaCode && !hasSeparator) return 0;
+        if (digitRun(4) != 4) return 0;
+        if (i < text.size() && (isDigit(text[i]) || isAsciiAlpha(text[i]))) return 0;
+        return i;
+    }
+    
+    static bool isConnector(string_view word) {
+        for (string_view connector : {"de", "da", "do", "dos", "das", "di", "du", "van", "von"}) {
+            if (word == connector) return true;
+        }
+        return false;
+    }
+    
+    // Sequência de palavras capitalizadas ("Maria Silva", "João da Costa")
+    struct NameRun {
+        size_t start = 0;
+        size_t end = 0;
+        int words = 0;
+        bool pendingConnector = false;
+        
+        void flush(EntityMatches& out) {
+            if (words >= 2) out.push_back({PERSON, start, end});
+            words = 0;
+            pendingConnector = false;
+        }
+    };
+    
+    // Quando duas ocorrências se sobrepõem fica a mais longa (a primeira em
+    // caso de empate)
+    static void resolveOverlaps(EntityMatches& matches) {
+        auto byStart = [](const EntityMatch& a, const EntityMatch& b) {
+            return a.start < b.start;
+        };
+        // Quase sempre já vem ordenado; stable_sort alocaria um buffer à toa
+        if (!is_sorted(matches.begin(), matches.end(), byStart)) {
+            stable_sort(matches.begin(), matches.end(), byStart);
+        }
+        
+        size_t kept = 0;
+        for (size_t i = 0; i < matches.size(); ++i) {
+            if (kept > 0 && matches[i].start < matches[kept - 1].end) {
+                EntityMatch& previous = matches[kept - 1];
+                if (matches[i].end - matches[i].start > previous.end - previous.start) previous = matches[i];
+                continue;
+            }
+            matches[kept++] = matches[i];
+        }
+        matches.resize(kept);
+    }
+    
+public:
+    // Adiciona um nome ao dicionário; vale depois de build()
+    void addKnownEntity(string_view name, string_view type) {
+        string folded(name.size() * 2 + 4, '\0');
+        size_t length = foldCaseUtf8(name, folded.data(), folded.size());
+        if (length == 0) return;
+        folded.resize(length);
+        
+        size_t codePoints = 0;
+        for (unsigned char b : folded) codePoints += (b & 0xC0) != 0x80;
+        if (codePoints > MAX_GAZETTEER_CODE_POINTS) return;
+        
+        auto typeIt = find(gazetteerTypes.begin(), gazetteerTypes.end(), type);
+        if (typeIt == gazetteerTypes.end()) {
+            gazetteerTypes.emplace_back(type);
+            typeIt = gazetteerTypes.end() - 1;
+        }
+        
+        gazetteer.add(folded, static_cast<uint32_t>(gazetteerEntries.size()));
+        gazetteerEntries.emplace_back(static_cast<uint32_t>(typeIt - gazetteerTypes.begin()),
+                                      static_cast<uint32_t>(codePoints));
+    }
+    
+    // Carrega o dicionário de um arquivo, uma entrada por linha:
+    // "nome[<TAB>tipo]" (tipo padrão: PERSON). Linhas iniciadas por '#' são
+    // ignoradas.
+    void loadGazetteer(const string& path) {
+        ifstream file(path);
+        if (!file) {
+            throw runtime_error("Não foi possível abrir o dicionário de entidades: " + path);
+        }
+        
+        string line;
+        while (getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            
+            size_t tab = line.find('\t');
+            string_view entry(line);
+            addKnownEntity(entry.substr(0, tab), tab == string::npos ? PERSON : entry.substr(tab + 1));
+        }
+    }
+    
+    void build() {
+        gazetteer.build();
+    }
+    
+    // O vetor devolvido é alocado em `memory`
+    EntityMatches scan(string_view text, pmr::memory_resource* memory = pmr::get_default_resource()) const {
+        EntityMatches matches(memory);
+        const char* s = text.data();
+        const int32_t n = static_cast<int32_t>(min<size_t>(text.size(), INT32_MAX));
+        
+        NameRun run;
+        uint32_t state = 0;
+        // Início (em bytes) dos últimos code points, para localizar o começo
+        // das ocorrências do dicionário
+        array<uint32_t, MAX_GAZETTEER_CODE_POINTS> cpStarts{};
+        size_t cpCount = 0;
+        
+        int32_t wordStart = -1;
+        bool wordUpper = false;
+        bool wordHasLower = false;
+        
+        auto endWord = [&](int32_t end) {
+            if (wordStart < 0) return;
+            string_view word(s + wordStart, static_cast<size_t>(end - wordStart));
+            if (wordUpper && wordHasLower) {
+                if (run.words == 0) run.start = static_cast<size_t>(wordStart);
+                run.end = static_cast<size_t>(end);
+                ++run.words;
+                run.pendingConnector = false;
+            } else if (run.words > 0 && !run.pendingConnector && isConnector(word)) {
+                run.pendingConnector = true;
+            } else {
+                run.flush(matches);
+            }
+            wordStart = -1;
+        };
+        
+        int32_t i = 0;
+        bool tokenStart = true;
+        while (i < n) {
+            unsigned char b = static_cast<unsigned char>(s[i]);
+            
+            // Reconhecedores de trechos inteiros, testados no início de cada
+            // trecho sem espaços; uma ocorrência é consumida de uma vez
+            if (tokenStart && !isspace(b)) {
+                tokenStart = false;
+                size_t tokenEnd = static_cast<size_t>(i);
+                while (tokenEnd < text.size() && !isspace(static_cast<unsigned char>(s[tokenEnd]))) ++tokenEnd;
+                
+                size_t start = static_cast<size_t>(i);
+                while (start < tokenEnd && isOneOf(s[start], "(<[\"'")) ++start;
+                size_t end = tokenEnd;
+                while (end > start && isOneOf(s[end - 1], ".,;:!?)>]\"'")) --end;
+                
+                optional<string_view> type;
+                size_t matchEnd = matchPhone(text, static_cast<size_t>(i));
+                if (matchEnd != 0) {
+                    start = static_cast<size_t>(i);
+                    type = PHONE;
+                } else if (end > start && (type = classifyToken(text.substr(start, end - start)))) {
+                    matchEnd = end;
+                }
+                
+                if (type) {
+                    endWord(i);
+                    run.flush(matches);
+                    matches.push_back({*type, start, matchEnd});
+                    state = 0;
+                    i = static_cast<int32_t>(matchEnd);
+                    continue;
+                }
+            }
+            
+            int32_t cpStart = i;
+            UChar32 c;
+            U8_NEXT(s, i, n, c);
+            
+            bool letter = c >= 0 && (c < 0x80 ? isAsciiAlpha(static_cast<char>(c)) : static_cast<bool>(u_isalpha(c)));
+            if (letter) {
+                if (wordStart < 0) {
+                    wordStart = cpStart;
+                    wordUpper = u_isupper(c);
+                    wordHasLower = false;
+                } else if (u_islower(c)) {
+                    wordHasLower = true;
+                }
+            } else {
+                endWord(cpStart);
+                if (c != ' ') run.flush(matches);
+                if (isspace(b)) tokenStart = true;
+            }
+            
+            // Dicionário de nomes conhecidos, sobre o texto com case folding
+            if (!gazetteer.empty()) {
+                cpStarts[cpCount++ % MAX_GAZETTEER_CODE_POINTS] = static_cast<uint32_t>(cpStart);
+                
+                uint8_t folded[4];
+                int32_t length = 0;
+                UBool error = false;
+                UChar32 f = c >= 0 ? u_foldCase(c, U_FOLD_CASE_DEFAULT) : 0xFFFD;
+                U8_APPEND(folded, length, 4, f, error);
+                (void)error;  // f é sempre um code point válido e cabe em 4 bytes
+                for (int32_t k = 0; k < length; ++k) state = gazetteer.step(state, folded[k]);
+                
+                gazetteer.forEachMatch(state, [&](uint32_t id, uint32_t) {
+                    uint32_t codePoints = gazetteerEntries[id].second;
+                    size_t start = cpStarts[(cpCount - codePoints) % MAX_GAZETTEER_CODE_POINTS];
+                    
+                    // Só vale em fronteira de palavra dos dois lados
+                    if (start > 0) {
+                        int32_t p = static_cast<int32_t>(start);
+                        UChar32 before;
+                        U8_PREV(s, 0, p, before);
+                        if (isLetterOrDigit(before)) return;
+                    }
+                    if (i < n) {
+                        int32_t p = i;
+                        UChar32 after;
+                        U8_NEXT(s, p, n, after);
+                        if (isLetterOrDigit(after)) return;
+                    }
+                    matches.push_back({gazetteerTypes[gazetteerEntries[id].first], start, static_cast<size_t>(i)});
+                });
+            }
+        }
+        endWord(n);
+        run.flush(matches);
+        
+        resolveOverlaps(matches);
+        return matches;
+    }
+    
+    // Ocorrências que começam em [begin, end), com posições relativas a
+    // `text`. `begin` precisa ser um corte de splitAtSentences; o trecho é
+    // lido um pouco além de `end` para achar nomes do dicionário que
+    // atravessam o corte.
+    EntityMatches scanRange(string_view text, size_t begin, size_t end) const {
+        size_t windowEnd = min(text.size(), end + MAX_GAZETTEER_CODE_POINTS * 4 + 4);
+        EntityMatches matches = scan(text.substr(begin, windowEnd - begin));
+        size_t kept = 0;
+        for (auto& match : matches) {
+            if (begin + match.start >= end) continue;  // pertence ao próximo segmento
+            matches[kept++] = {match.type, begin + match.start, begin + match.end};
+        }
+        matches.resize(kept);
+        return matches;
+    }
+    
+    // Junta os resultados de scanRange dos segmentos, em ordem, descartando
+    // repetições e resolvendo sobreposições nos cortes como scan() faria
+    static EntityMatches merge(vector<EntityMatches> parts, pmr::memory_resource* memory = pmr::get_default_resource()) {
+        EntityMatches matches(memory);
+        for (auto& part : parts) matches.insert(matches.end(), part.begin(), part.end());
+        matches.erase(unique(matches.begin(), matches.end(), [](const EntityMatch& a, const EntityMatch& b) {
+            return a.start == b.start && a.end == b.end && a.type == b.type;
+        }), matches.end());
+        resolveOverlaps(matches);
+        return matches;
+    }
+    
+    static vector<pair<string, string>> toPairs(string_view text, const EntityMatches& matches) {
+        vector<pair<string, string>> entities;
+        entities.reserve(matches.size());
+        for (const auto& match : matches) {
+            entities.emplace_back(string(match.type), string(text.substr(match.start, match.end - match.start)));
+        }
+        return entities;
+    }
+    
+    vector<pair<string, string>> extract(string_view text) const {
+        return toPairs(text, scan(text));
+    }
+};
+
+// Intenções reconhecidas em generateResponse, em ordem de prioridade
+enum class Intent : uint8_t {
+    CreatePresentation,
+    CreateSpreadsheet,
+    Chat  // nenhuma palavra-chave: conversa normal
+};
+
+// Roteador de intenções: as palavras-chave de todas as intenções ficam num
+// único autômato de Aho-Corasick sobre o texto normalizado (minúsculas, sem
+// acentos do Latin-1 e espaços colapsados), então o roteamento é uma passada
+// só sobre a entrada, qualquer que seja o número de intenções.
+class IntentRouter {
+private:
+    // Letra base de U+00C0..U+00FF em minúscula; '.' mantém o caractere
+    static constexpr string_view LATIN1_BASE =
+        "aaaaaa.ceeeeiiii"   // U+00C0
+        ".nooooo.ouuuuy.."   // U+00D0
+        "aaaaaa.ceeeeiiii"   // U+00E0
+        ".nooooo.ouuuuy.y";  // U+00F0
+    
+    AhoCorasick keywords;
+    vector<Intent> keywordIntents;
+    
+    // Chama emit(byte) para cada byte do texto normalizado
+    template<typename F>
+    static void normalize(string_view text, F&& emit) {
+        const char* s = text.data();
+        const int32_t n = static_cast<int32_t>(min<size_t>(text.size(), INT32_MAX));
+        int32_t i = 0;
+        bool lastSpace = false;
+        
+        while (i < n) {
+            unsigned char b = static_cast<unsigned char>(s[i]);
+            if (b < 0x80) {
+                ++i;
+                if (isspace(b)) {
+                    if (!lastSpace) emit(' ');
+                    lastSpace = true;
+                    continue;
+                }
+                emit(static_cast<uint8_t>(b >= 'A' && b <= 'Z' ? b + 32 : b));
+                lastSpace = false;
+                continue;
+            }
+            
+            lastSpace = false;
+            UChar32 c;
+            U8_NEXT(s, i, n, c);
+            if (c < 0) {
+                emit(0xFF);  // byte inválido: nunca aparece numa palavra-chave
+                continue;
+            }
+            if (c >= 0xC0 && c <= 0xFF && LATIN1_BASE[c - 0xC0] != '.') {
+                emit(static_cast<uint8_t>(LATIN1_BASE[c - 0xC0]));
+                continue;
+            }
+            
+            uint8_t folded[4];
+            int32_t length = 0;
+            UBool error = false;
+            U8_APPEND(folded, length, 4, u_foldCase(c, U_FOLD_CASE_DEFAULT), error);
+            (void)error;  // code point válido sempre cabe em 4 bytes
+            for (int32_t k = 0; k < length; ++k) emit(folded[k]);
+        }
+    }
+    
+public:
+    IntentRouter() {
+        add("criar apresentação", Intent::CreatePresentation);
+        add("gerar ppt", Intent::CreatePresentation);
+        add("criar planilha", Intent::CreateSpreadsheet);
+        add("gerar excel", Intent::CreateSpreadsheet);
+        keywords.build();
+    }
+    
+    // A palavra-chave passa pela mesma normalização do texto
+    void add(string_view keyword, Intent intent) {
+        string normalized;
+        normalize(keyword, [&](uint8_t b) { normalized += static_cast<char>(b); });
+        keywords.add(normalized, static_cast<uint32_t>(keywordIntents.size()));
+        keywordIntents.push_back(intent);
+    }
+    
+    Intent route(string_view input) const {
+        Intent best = Intent::Chat;
+        uint32_t state = 0;
+        normalize(input, [&](uint8_t b) {
+            state = keywords.step(state, b);
+            keywords.forEachMatch(state, [&](uint32_t id, uint32_t) {
+                best = min(best, keywordIntents[id]);
+            });
+        });
+        return best;
+    }
+};
@@ -0,0 +1,176 @@
+// worker_pool.h - Pool de threads compartilhado
+#pragma once
+
+#include "common.h"
+
+// Pool fixo de threads para trabalho de CPU compartilhado pelo servidor
+// (compressão de partes de documentos, lotes de textos, etc.). submit()
+// devolve um future.
+//
+// Cada thread tem sua própria fila: tarefas enviadas de dentro do pool vão
+// para a fila da thread que as criou, as de fora são distribuídas em rodízio.
+// A thread consome a própria fila pelo fim (a tarefa mais recente, ainda
+// quente no cache) e, quando ela esvazia, rouba do início da fila das outras.
+class WorkerPool {
+private:
+    struct WorkQueue {
+        mutex mtx;
+        deque<function<void()>> tasks;
+    };
+    
+    vector<unique_ptr<WorkQueue>> queues;
+    vector<thread> threads;
+    atomic<size_t> nextQueue{0};
+    
+    // Só para dormir e acordar: `pending` muda sob `sleepMutex` ao enfileirar,
+    // então nenhuma thread dorme com tarefa disponível
+    mutex sleepMutex;
+    condition_variable cv;
+    atomic<size_t> pending{0};
+    bool stopping = false;
+    
+    static thread_local WorkerPool* currentPool;
+    static thread_local size_t currentIndex;
+    
+    bool tryPop(size_t self, function<void()>& task) {
+        {
+            WorkQueue& own = *queues[self];
+            lock_guard<mutex> lock(own.mtx);
+            if (!own.tasks.empty()) {
+                task = move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            WorkQueue& victim = *queues[(self + offset) % queues.size()];
+            lock_guard<mutex> lock(victim.mtx);
+            if (!victim.tasks.empty()) {
+                task = move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void workerLoop(size_t self) {
+        currentPool = this;
+        currentIndex = self;
+        while (true) {
+            function<void()> task;
+            if (tryPop(self, task)) {
+                pending.fetch_sub(1, memory_order_relaxed);
+                task();
+                continue;
+            }
+            
+            unique_lock<mutex> lock(sleepMutex);
+            cv.wait(lock, [this] { return stopping || pending.load(memory_order_relaxed) > 0; });
+            if (stopping && pending.load(memory_order_relaxed) == 0) return;
+        }
+    }
+    
+    void push(function<void()> task) {
+        size_t index = currentPool == this ? currentIndex
+                                            : nextQueue.fetch_add(1, memory_order_relaxed) % queues.size();
+        {
+            WorkQueue& queue = *queues[index];
+            lock_guard<mutex> lock(queue.mtx);
+            queue.tasks.push_back(move(task));
+        }
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            pending.fetch_add(1, memory_order_relaxed);
+        }
+        cv.notify_one();
+    }
+    
+public:
+    explicit WorkerPool(size_t count) {
+        count = max<size_t>(count, 1);
+        queues.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            queues.push_back(make_unique<WorkQueue>());
+        }
+        threads.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+    
+    ~WorkerPool() {
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& t : threads) t.join();
+    }
+    
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    
+    template <typename F>
+    auto submit(F&& fn) -> future<invoke_result_t<F>> {
+        using R = invoke_result_t<F>;
+        auto task = make_shared<packaged_task<R()>>(forward<F>(fn));
+        future<R> result = task->get_future();
+        push([task] { (*task)(); });
+        return result;
+    }
+    
+    // Executa fn(0), ..., fn(count - 1) no pool com a thread chamadora
+    // ajudando, e só retorna quando todas terminarem. Como quem chama também
+    // consome índices, pode ser usado de dentro de uma tarefa do pool sem
+    // risco de todas as threads ficarem esperando umas pelas outras. A
+    // primeira exceção de fn é relançada aqui.
+    template <typename F>
+    void parallelFor(size_t count, F&& fn) {
+        if (count == 0) return;
+        struct Progress {
+            atomic<size_t> next{0};
+            atomic<size_t> done{0};
+            mutex mtx;
+            condition_variable finished;
+            exception_ptr error;
+        };
+        auto progress = make_shared<Progress>();
+        
+        // Ajudantes que começam depois do último índice saem sem tocar em fn
+        auto work = [progress, count, &fn] {
+            size_t index;
+            while ((index = progress->next.fetch_add(1)) < count) {
+                try {
+                    fn(index);
+                } catch (...) {
+                    lock_guard<mutex> lock(progress->mtx);
+                    if (!progress->error) progress->error = current_exception();
+                }
+                if (progress->done.fetch_add(1) + 1 == count) {
+                    lock_guard<mutex> lock(progress->mtx);
+                    progress->finished.notify_all();
+                }
+            }
+        };
+        
+        size_t helpers = min(count, threads.size() + 1) - 1;
+        for (size_t i = 0; i < helpers; ++i) push(work);
+        work();
+        
+        unique_lock<mutex> lock(progress->mtx);
+        progress->finished.wait(lock, [&] { return progress->done.load() == count; });
+        if (progress->error) rethrow_exception(progress->error);
+    }
+    
+    size_t size() const { return threads.size(); }
+    
+    // Pool do processo, com uma thread por núcleo
+    static WorkerPool& shared() {
+        static WorkerPool pool(thread::hardware_concurrency());
+        return pool;
+    }
+};
+
+inline thread_local WorkerPool* WorkerPool::currentPool = nullptr;
+inline thread_local size_t WorkerPool::currentIndex = 0;